@@ -0,0 +1,26 @@
+meta:
+	ADDON_NAME = ofxThreadedVideo
+	ADDON_DESCRIPTION = Non-blocking, threaded video playback
+	ADDON_AUTHOR = Matthew Gingold
+	ADDON_TAGS = "video" "threaded" "quicktime"
+	ADDON_URL = https://github.com/gameoverhack/ofxThreadedVideo
+
+common:
+
+# the QuickTime backend only builds on 32-bit OSX and Windows; everywhere else
+# the engine runs with the platform's player or ofxThreadedVideoY4MPlayer
+linux64:
+	ADDON_SOURCES_EXCLUDE = libs/ofQuickTimePlayer/%
+	ADDON_INCLUDES_EXCLUDE = libs/ofQuickTimePlayer
+
+linux:
+	ADDON_SOURCES_EXCLUDE = libs/ofQuickTimePlayer/%
+	ADDON_INCLUDES_EXCLUDE = libs/ofQuickTimePlayer
+
+linuxarmv6l:
+	ADDON_SOURCES_EXCLUDE = libs/ofQuickTimePlayer/%
+	ADDON_INCLUDES_EXCLUDE = libs/ofQuickTimePlayer
+
+linuxarmv7l:
+	ADDON_SOURCES_EXCLUDE = libs/ofQuickTimePlayer/%
+	ADDON_INCLUDES_EXCLUDE = libs/ofQuickTimePlayer
@@ -7,6 +7,9 @@ void ofApp::setup(){
     ofSetFrameRate(2000);
     ofSetLogLevel(OF_LOG_VERBOSE);
 
+    // repeat runs skip scanning every sample of movies they've seen before
+    ofxThreadedVideoMetadataCache::getCache().open(ofToDataPath("ofxThreadedVideoMetadata.cache", true));
+    
     files.allowExt("mov");
     files.listDir("/Users/gameover/Desktop/media"); // put a video path here with several video files in a folder
 
@@ -14,6 +17,8 @@ void ofApp::setup(){
     
     lastLoadTime = ofGetElapsedTimeMillis();
     loadInterval = 100;
+    updateMicros = 0.0f;
+    bGaplessCheck = false;
     
     ofBackground(0, 0, 0);
     
@@ -31,12 +36,17 @@ void ofApp::setup(){
 
 //--------------------------------------------------------------
 void ofApp::update(){
+    unsigned long long timeStart = ofGetElapsedTimeMicros();
     for(int i = 0; i < maxVideos;i++){
         videos[i]->update();
     }
+    updateMicros = updateMicros * 0.95f + (ofGetElapsedTimeMicros() - timeStart) * 0.05f;
+    if(bGaplessCheck) updateGaplessCheck();
     if(ofGetElapsedTimeMillis() - lastLoadTime >= loadInterval){
         lastLoadTime = ofGetElapsedTimeMillis();
         int i = (int)ofRandom(maxVideos);
+        // leave the playlist alone while it's being checked
+        if(bGaplessCheck && i == 0) return;
         videos[i]->loadMovie(files.getPath(ofRandom(files.size())));
         videos[i]->play();
     }
@@ -63,11 +73,215 @@ void ofApp::draw(){
     ofSetColor(0, 255, 0);
     
     ostringstream os;
-    os << "FPS: " << ofGetFrameRate() << " loadInterval = " << loadInterval << " ms" << endl;
+    os << "FPS: " << ofGetFrameRate() << " loadInterval = " << loadInterval << " ms update = " << updateMicros << " us"
+       << (maxVideos > 0 && videos[0]->getBackendOnWorker() ? " (backend on worker)" : "")
+       << (maxVideos > 0 && videos[0]->getOutputWidth() > 0 ? " (decoding to tile size)" : "") << endl;
+    ofxThreadedVideoBufferPool& buffers = ofxThreadedVideoBufferPool::getPool();
+    os << "frame buffers: " << buffers.getBytesInUse() / 1024 << " KB in use " << buffers.getBytesIdle() / 1024 << " KB idle, high water "
+       << buffers.getHighWaterBytes() / 1024 << " KB / " << buffers.getHighWaterBuffers() << " buffers, "
+       << buffers.getNumAllocations() << " allocated " << buffers.getNumReuses() << " reused" << endl;
+    ofxThreadedVideoMetadataCache& metadata = ofxThreadedVideoMetadataCache::getCache();
+    os << "metadata cache: " << metadata.getNumEntries() << " movies, " << metadata.getHits() << " hits "
+       << metadata.getMisses() << " misses, " << metadata.getMappedBytes() / 1024 << " KB mapped" << endl;
     for(int i = 0; i < maxVideos; i++){
-        os << i << " " << videos[i]->getFrameRate() << " " << videos[i]->getCurrentFrame() << " / " << videos[i]->getTotalNumFrames() << " " << videos[i]->getQueueSize() << endl;
+        ofxThreadedVideoState state = videos[i]->getState();
+        os << i << " " << state.frameRate << " " << state.frameCurrent << " / " << state.frameTotal << " " << videos[i]->getQueueSize() << " coalesced " << videos[i]->getQueueCoalesced() << " cancelled " << videos[i]->getQueueCancelled()
+           << " decode ahead " << videos[i]->getDecodeAheadOccupancy() << "/" << videos[i]->getDecodeAhead()
+           << " underruns " << videos[i]->getDecodeAheadUnderruns() << " dropped " << videos[i]->getDecodeAheadDropped() << endl;
     }
     ofDrawBitmapString(os.str(), 20, ofGetHeight() - 20 * maxVideos);
+    
+    ofDrawBitmapString(benchmarkResults, 20, 20);
+}
+
+//--------------------------------------------------------------
+static void enqueueProducer(ofxThreadedVideo * video, int numCommands, double * nanosPerCommand){
+    double total = 0;
+    for(int i = 0; i < numCommands; i++){
+        chrono::high_resolution_clock::time_point t0 = chrono::high_resolution_clock::now();
+        video->setVolume((float)(i % 100) / 100.0f);
+        chrono::high_resolution_clock::time_point t1 = chrono::high_resolution_clock::now();
+        total += chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+        // keep the ring from overflowing - we're measuring enqueue, not the drop path
+        if(video->getQueueSize() > OFX_THREADED_VIDEO_QUEUE_SIZE / 2) video->flush();
+    }
+    *nanosPerCommand = total / numCommands;
+}
+
+//--------------------------------------------------------------
+void ofApp::runEnqueueBenchmark(){
+    
+    const int numCommands = 100000;
+    ostringstream os;
+    os << "enqueue latency (mean ns per command, one producer thread per instance)" << endl;
+    
+    for(int numInstances = 1; numInstances <= 32; numInstances *= 2){
+        
+        vector<ofxThreadedVideo*> instances(numInstances);
+        for(int i = 0; i < numInstances; i++) instances[i] = new ofxThreadedVideo;
+        
+        vector<double> results(numInstances);
+        vector<thread> producers;
+        for(int i = 0; i < numInstances; i++){
+            producers.push_back(thread(enqueueProducer, instances[i], numCommands, &results[i]));
+        }
+        for(int i = 0; i < numInstances; i++) producers[i].join();
+        
+        double mean = 0, worst = 0;
+        for(int i = 0; i < numInstances; i++){
+            mean += results[i] / numInstances;
+            worst = MAX(worst, results[i]);
+        }
+        os << numInstances << " instances: mean " << mean << " ns worst producer " << worst << " ns" << endl;
+        
+        for(int i = 0; i < numInstances; i++) delete instances[i];
+    }
+    
+    benchmarkResults = os.str();
+    ofLogNotice() << benchmarkResults;
+}
+
+//--------------------------------------------------------------
+static bool updateUntil(vector<ofxThreadedVideo*>& instances, function<bool()> done, float timeoutSeconds = 60.0f){
+    float timeStart = ofGetElapsedTimef();
+    while(!done()){
+        for(int i = 0; i < instances.size(); i++) instances[i]->update();
+        if(ofGetElapsedTimef() - timeStart > timeoutSeconds) return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::runScalingBenchmark(){
+    
+    if(files.size() == 0) return;
+    
+    const int commandsPerInstance = 100;
+    const int loadsPerInstance = 4;
+    
+    ostringstream os;
+    os << "scaling (aggregate throughput, " << commandsPerInstance << " seeks and " << loadsPerInstance << " loads per instance)" << endl;
+    
+    for(int numInstances = 1; numInstances <= 16; numInstances *= 2){
+        
+        vector<ofxThreadedVideo*> instances(numInstances);
+        for(int i = 0; i < numInstances; i++){
+            instances[i] = new ofxThreadedVideo;
+            instances[i]->setPixelFormat(OF_PIXELS_BGRA);
+            instances[i]->loadMovie(files.getPath(i % files.size()));
+        }
+        
+        bool bOk = updateUntil(instances, [&]{
+            for(int i = 0; i < numInstances; i++) if(!instances[i]->isLoaded()) return false;
+            return true;
+        });
+        
+        // seeks are executed by each instance's worker; a seek still waiting
+        // in the queue just takes the newer position, so only count the
+        // ones that actually ran
+        int coalescedBefore = 0;
+        for(int i = 0; i < numInstances; i++) coalescedBefore += instances[i]->getQueueCoalesced();
+        float timeStart = ofGetElapsedTimef();
+        for(int i = 0; i < numInstances; i++){
+            for(int j = 0; j < commandsPerInstance; j++){
+                instances[i]->setPosition(j % 2 == 0 ? 0.25f : 0.75f);
+            }
+        }
+        bOk &= updateUntil(instances, [&]{
+            for(int i = 0; i < numInstances; i++) if(instances[i]->getQueueSize() > 0) return false;
+            return true;
+        });
+        float seconds = ofGetElapsedTimef() - timeStart;
+        int coalesced = -coalescedBefore;
+        for(int i = 0; i < numInstances; i++) coalesced += instances[i]->getQueueCoalesced();
+        int executed = numInstances * commandsPerInstance - coalesced;
+        float commandsPerSecond = executed / seconds;
+        
+        // loads need update() to flip slots, so keep pumping it while waiting
+        int loadsBefore = instances[0]->getLoadOk() + instances[0]->getLoadFail();
+        timeStart = ofGetElapsedTimef();
+        for(int i = 0; i < numInstances; i++){
+            for(int j = 0; j < loadsPerInstance; j++){
+                instances[i]->loadMovie(files.getPath((i + j + 1) % files.size()));
+            }
+        }
+        bOk &= updateUntil(instances, [&]{
+            return instances[0]->getLoadOk() + instances[0]->getLoadFail() - loadsBefore >= numInstances * loadsPerInstance;
+        });
+        float loadsPerSecond = (numInstances * loadsPerInstance) / (ofGetElapsedTimef() - timeStart);
+        
+        os << numInstances << " instances: " << executed << " seeks executed (" << coalesced << " coalesced) "
+           << commandsPerSecond << " executed/sec " << loadsPerSecond << " loads/sec" << (bOk ? "" : " (timed out)") << endl;
+        
+        for(int i = 0; i < numInstances; i++) delete instances[i];
+    }
+    
+    benchmarkResults = os.str();
+    ofLogNotice() << benchmarkResults;
+}
+
+//--------------------------------------------------------------
+void ofApp::runLatencyBenchmark(){
+    
+    if(files.size() == 0) return;
+    
+    const int numCommands = 500;
+    
+    vector<ofxThreadedVideo*> instances(1, new ofxThreadedVideo);
+    ofxThreadedVideoHandle load = instances[0]->loadMovie(files.getPath(0));
+    instances[0]->play();
+    // the load is prepared in update() so poll the handle rather than wait() on it here
+    bool bOk = updateUntil(instances, [&]{ return load.isDone() && instances[0]->getQueueSize() == 0; });
+    
+    // push at irregular intervals so we don't phase lock with anything
+    for(int i = 0; i < numCommands; i++){
+        instances[0]->setVolume((float)(i % 2));
+        float timeNext = ofGetElapsedTimef() + ofRandom(0.002f, 0.02f);
+        bOk &= updateUntil(instances, [&]{ return ofGetElapsedTimef() >= timeNext; });
+    }
+    bOk &= updateUntil(instances, [&]{ return instances[0]->getQueueSize() == 0; });
+    
+    ostringstream os;
+    os << "enqueue -> execute latency over " << numCommands << " setVolume commands: p50 "
+       << instances[0]->getCommandLatency(0.5f) << " us p99 " << instances[0]->getCommandLatency(0.99f) << " us"
+       << (bOk ? "" : " (timed out)") << endl;
+    os << "load queued -> started " << (load.getTimeStarted() - load.getTimeQueued()) << " us, started -> finished "
+       << (load.getTimeFinished() - load.getTimeStarted()) << " us" << (load.getStatus() == VIDEO_HANDLE_DONE ? "" : " (failed)") << endl;
+    
+    delete instances[0];
+    
+    benchmarkResults = os.str();
+    ofLogNotice() << benchmarkResults;
+}
+
+//--------------------------------------------------------------
+void ofApp::updateGaplessCheck(){
+    
+    if(!videos[0]->isFrameNew()) return;
+    
+    unsigned long long timeNow = ofGetElapsedTimeMicros();
+    int index = videos[0]->getPlaylistIndex();
+    int frame = videos[0]->getCurrentFrame();
+    
+    if(index != gaplessIndex){
+        if(gaplessIndex != -1){
+            gaplessBoundaries++;
+            if(frame > 1) gaplessBadStarts++;
+            gaplessMaxGapMillis = MAX(gaplessMaxGapMillis, (timeNow - gaplessLastFrameMicros) / 1000.0f);
+        }
+        gaplessIndex = index;
+    }else if(frame == gaplessFrame){
+        gaplessDuplicates++;
+    }
+    
+    gaplessFrame = frame;
+    gaplessLastFrameMicros = timeNow;
+    
+    ostringstream os;
+    os << "gapless playlist: " << gaplessBoundaries << " boundaries, " << gaplessBadStarts << " late starts, "
+       << gaplessDuplicates << " repeated frames, longest boundary gap " << gaplessMaxGapMillis << " ms ("
+       << 1000.0 / MAX(1.0, videos[0]->getFrameRate()) << " ms between new frames)" << endl;
+    benchmarkResults = os.str();
 }
 
 //--------------------------------------------------------------
@@ -85,6 +299,45 @@ void ofApp::keyPressed(int key){
             videos[i]->play();
             break;
         }
+        case 'e':
+            runEnqueueBenchmark();
+            break;
+        case 's':
+            runScalingBenchmark();
+            break;
+        case 'l':
+            runLatencyBenchmark();
+            break;
+        case 'g':
+        {
+            if(maxVideos == 0) break;
+            vector<string> paths;
+            for(int i = 0; i < MIN(3, files.numFiles()); i++) paths.push_back(files.getPath(i));
+            videos[0]->setPlaylist(paths);
+            bGaplessCheck = true;
+            gaplessIndex = gaplessFrame = -1;
+            gaplessBoundaries = gaplessBadStarts = gaplessDuplicates = 0;
+            gaplessMaxGapMillis = 0.0f;
+            break;
+        }
+        case 'd':
+            for(int i = 0; i < maxVideos; i++) videos[i]->setDecodeAhead(videos[i]->getDecodeAhead() == 0 ? 3 : 0);
+            break;
+        case 'w':
+            for(int i = 0; i < maxVideos; i++) videos[i]->setBackendOnWorker(!videos[i]->getBackendOnWorker());
+            break;
+        case 't':
+        {
+            // tiles are drawn ofGetWidth() / 10 wide, so there's no point uploading anything bigger
+            int tileWidth = maxVideos > 0 && videos[0]->getOutputWidth() == 0 ? ofGetWidth() / 10 : 0;
+            for(int i = 0; i < maxVideos; i++) videos[i]->setOutputSize(tileWidth, 0);
+            break;
+        }
+        case 'p':
+            // only affects instances created from now on, ie., the benchmarks
+            ofxThreadedVideo::setUseWorkerPool(!ofxThreadedVideo::getUseWorkerPool());
+            benchmarkResults = string("benchmark instances ") + (ofxThreadedVideo::getUseWorkerPool() ? "share the worker pool" : "run a thread each");
+            break;
         case OF_KEY_UP:
             loadInterval = loadInterval + 10;
             break;
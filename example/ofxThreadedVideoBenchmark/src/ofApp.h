@@ -21,6 +21,7 @@ class ofApp : public ofBaseApp{
 		void gotMessage(ofMessage msg);
 
         int lastLoadTime, loadInterval;
+        float updateMicros; // smoothed time spent in all the videos' update() per frame
         ofDirectory files;
 
         vector<ofxThreadedVideo*> videos;
@@ -28,5 +29,21 @@ class ofApp : public ofBaseApp{
         int maxVideos;
     
         void threadedVideoEvent(ofxThreadedVideoEvent & event);
+    
+        // press 'e': enqueue latency with 1..32 instances each fed by its own producer thread
+        void runEnqueueBenchmark();
+        // press 's': aggregate commands/sec and loads/sec with 1..16 instances
+        void runScalingBenchmark();
+        // press 'l': p50/p99 enqueue -> execute latency for worker side commands
+        void runLatencyBenchmark();
+        // press 'g': play the first three files as a gapless playlist on
+        // video 0 and watch the boundaries - with a frame counter clip every
+        // item should start at frame 0 with no repeated frame before it
+        void updateGaplessCheck();
+        bool bGaplessCheck;
+        int gaplessIndex, gaplessFrame, gaplessBoundaries, gaplessBadStarts, gaplessDuplicates;
+        unsigned long long gaplessLastFrameMicros;
+        float gaplessMaxGapMillis;
+        string benchmarkResults;
 
 };
@@ -28,6 +28,11 @@ void ofApp::setup(){
     video2.loadMovie(files.getPath(ofRandom(files.numFiles())));
     video2.play();
     
+    // keep the next few cues open so stepping to them is instant
+    nextCue = 0;
+    video1.setPreloadCache(4);
+    for(int i = 0; i < MIN(4, files.numFiles()); i++) video1.preload(files.getPath(i));
+    
     ofBackground(0, 0, 0);
     
     ofAddListener(video1.threadedVideoEvent, this, &ofApp::threadedVideoEvent);
@@ -48,7 +53,7 @@ void ofApp::draw(){
     
     ostringstream os;
     os << "FPS: " << ofGetFrameRate() << endl;
-    os << "use keys '<' '>' and  ' ' to load movies, 'p' to toggle pause," << endl;
+    os << "use keys '<' '>' and  ' ' to load movies, 'n' for the next cue, 'p' to toggle pause," << endl;
     os << "L/R arrow keys to jump frames and U/D arrow keys to change speed" << endl;
     os << video1.getCurrentFrame() << "/" << video1.getTotalNumFrames() << " " << video1.getSpeed() << endl;
     os << video2.getCurrentFrame() << "/" << video2.getTotalNumFrames() << " " << video2.getSpeed() << endl;
@@ -80,6 +85,24 @@ void ofApp::keyPressed(int key){
             video2.loadMovie(files.getPath(ofRandom(files.numFiles())));
             video2.play();
             break;
+        case 'c':
+            // a whole cue applied at once: no frame is shown until it's all done
+            video1.beginBatch();
+            video1.loadMovie(files.getPath(ofRandom(files.numFiles())));
+            video1.setLoopState(OF_LOOP_NORMAL);
+            video1.setVolume(1.0f);
+            video1.setFade(0, 1000, 1.0f);
+            video1.play();
+            video1.endBatch();
+            break;
+        case 'n':
+            // a preload cache hit, then open the cue that's now 4 ahead
+            if(files.numFiles() == 0) break;
+            video1.loadMovie(files.getPath(nextCue));
+            video1.play();
+            video1.preload(files.getPath((nextCue + 4) % files.numFiles()));
+            nextCue = (nextCue + 1) % files.numFiles();
+            break;
         case 'p':
             video1.setPaused(!video1.isPaused());
             video2.setPaused(!video2.isPaused());
@@ -21,6 +21,7 @@ class ofApp : public ofBaseApp{
 		void gotMessage(ofMessage msg);
     
         ofDirectory files;
+        int nextCue; // video1 steps through files in order with 'n', preloading ahead
     
         ofxThreadedVideo video1;
         ofxThreadedVideo video2;
@@ -0,0 +1,13 @@
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+
+//========================================================================
+int main( ){
+	ofAppNoWindow window;
+	ofSetupOpenGL(&window, 1920, 1080, OF_WINDOW);	// <-------- no GL context, nothing is drawn
+    
+	// this kicks off the running of my app
+	ofRunApp(new ofApp());
+    
+}
@@ -0,0 +1,443 @@
+#include "ofApp.h"
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+
+    ofSetFrameRate(60);
+    ofSetLogLevel(OF_LOG_NOTICE);
+    
+    phase = PHASE_DONE;
+    bPlaylistFailed = false;
+    
+    if(!checkCommandOrder()){
+        ofExit(1);
+        return;
+    }
+    
+    benchmarkConvert(1920, 1080);
+    benchmarkConvert(3840, 2160);
+
+    files.allowExt("y4m");
+    files.listDir("media");
+    
+    if(files.size() == 0){
+        ofLogError() << "no .y4m files in " << ofToDataPath("media", true);
+        ofExit(1);
+        return;
+    }
+    
+    // convert anything we haven't seen before
+    ofDirectory::createDirectory("media/raw", true, true);
+    for(int i = 0; i < files.size(); i++){
+        string rawPath = "media/raw/" + ofFilePath::removeExt(files.getName(i)) + ".ofxraw";
+        if(!ofFile::doesFileExist(rawPath)) convertToRaw(files.getPath(i), rawPath);
+    }
+    rawFiles.allowExt("ofxraw");
+    rawFiles.listDir("media/raw");
+    
+    numVideos = 16;
+    phaseSeconds = 10;
+    loadInterval = 500;
+    
+    startPhase(PHASE_THREAD_PER_INSTANCE);
+}
+
+//--------------------------------------------------------------
+void ofApp::startPhase(Phase _phase){
+    
+    phase = _phase;
+    if(phase == PHASE_DONE){
+        ofExit(bPlaylistFailed ? 1 : 0);
+        return;
+    }
+    
+    // has to be decided before the instances exist
+    ofxThreadedVideo::setUseWorkerPool(phase != PHASE_THREAD_PER_INSTANCE);
+    
+    int phaseVideos = numVideos;
+    int numClips = 0;
+    if(phase == PHASE_PLAYLIST){
+        // needs no media, the clips are written here. one instance plays
+        // them from the update thread, the other decodes ahead on the worker
+        int clipFrames = 40;
+        playlist.clear();
+        ofDirectory::createDirectory("playlist", true, true);
+        for(int i = 0; i < 3; i++){
+            string path = "playlist/counter" + ofToString(i) + ".y4m";
+            if(!writeCounterClip(path, i * clipFrames, clipFrames)){
+                bPlaylistFailed = true;
+                startPhase(PHASE_DONE);
+                return;
+            }
+            playlist.push_back(path);
+        }
+        numPlaylistFrames = playlist.size() * clipFrames;
+        phaseVideos = 2;
+        numClips = playlist.size();
+    }else{
+        phaseFiles = phase == PHASE_RAW_FRAMES ? &rawFiles : &files;
+        if(phaseFiles->size() == 0){
+            startPhase((Phase)(phase + 1));
+            return;
+        }
+        numClips = phaseFiles->size();
+    }
+    
+    videos.resize(phaseVideos);
+    playlistChecks.resize(phaseVideos);
+    for(int i = 0; i < phaseVideos; i++){
+        videos[i] = new ofxThreadedVideo;
+        if(phase == PHASE_RAW_FRAMES){
+            videos[i]->setPlayer<ofxThreadedVideoRawPlayer>();
+        }else{
+            videos[i]->setPlayer<ofxThreadedVideoY4MPlayer>();
+        }
+        videos[i]->setUseTexture(false);
+        // the playlist check reads its counter straight out of the luma plane
+        videos[i]->setPixelFormat(phase == PHASE_PLAYLIST ? OF_PIXELS_I420 : OF_PIXELS_BGRA);
+        if(phase == PHASE_BACKEND_ON_WORKER || (phase == PHASE_PLAYLIST && i == 1)){
+            videos[i]->setBackendOnWorker(true);
+            videos[i]->setDecodeAhead(3);
+        }
+        if(phase == PHASE_PLAYLIST){
+            PlaylistCheck& check = playlistChecks[i];
+            check.lastFrame = -1;
+            check.numFrames = check.numBlack = check.numRepeated = check.numSkipped = check.numSkippedJoins = 0;
+            videos[i]->setPlaylist(playlist);
+            continue;
+        }
+        videos[i]->loadMovie(phaseFiles->getPath(i % phaseFiles->size()));
+        videos[i]->play();
+    }
+    
+    phaseStarted = lastLoadTime = lastReport = ofGetElapsedTimeMillis();
+    updateMicros = framesPresented = numUpdates = framesSinceReport = 0;
+    
+    ofLogNotice() << "phase " << getPhaseName(phase) << ": " << phaseVideos << " instances, " << numClips << " clips";
+}
+
+//--------------------------------------------------------------
+void ofApp::endPhase(){
+    
+    float seconds = (ofGetElapsedTimeMillis() - phaseStarted) / 1000.0f;
+    ofLogNotice() << "phase " << getPhaseName(phase) << " done: "
+                  << framesPresented / seconds << " frames/s presented, "
+                  << (numUpdates > 0 ? updateMicros / numUpdates : 0) << " us per app update";
+    
+    if(phase != PHASE_PLAYLIST){
+        ofLogNotice() << "phase " << getPhaseName(phase) << " enqueue -> execute latency on instance 0: p50 "
+                      << videos[0]->getCommandLatency(0.5f) << " us, p99 " << videos[0]->getCommandLatency(0.99f) << " us";
+    }
+    
+    if(phase == PHASE_PLAYLIST){
+        for(int i = 0; i < playlistChecks.size(); i++){
+            PlaylistCheck& check = playlistChecks[i];
+            string name = i == 1 ? "decode ahead on worker" : "update thread";
+            ofLogNotice() << "playlist, " << name << ": " << check.numFrames << " frames, " << check.numBlack << " black, "
+                          << check.numRepeated << " repeated, " << check.numSkipped << " skipped (" << check.numSkippedJoins << " at joins)";
+            // a skip is the app running late as much as a gap, so only those are fatal
+            if(check.numFrames == 0 || check.numBlack > 0 || check.numRepeated > 0) bPlaylistFailed = true;
+        }
+    }
+    
+    for(int i = 0; i < videos.size(); i++){
+        delete videos[i];
+    }
+    videos.clear();
+    
+    startPhase((Phase)(phase + 1));
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+    
+    if(phase == PHASE_DONE) return;
+    
+    unsigned long long timeStart = ofGetElapsedTimeMicros();
+    for(int i = 0; i < videos.size(); i++){
+        videos[i]->update();
+        if(videos[i]->isFrameNew()){
+            framesSinceReport++;
+            if(phase == PHASE_PLAYLIST) checkPlaylistFrame(i);
+        }
+    }
+    updateMicros += ofGetElapsedTimeMicros() - timeStart;
+    numUpdates++;
+    
+    unsigned long long timeNow = ofGetElapsedTimeMillis();
+    
+    // and the command path, for the latency figures at the end of the phase
+    if(phase != PHASE_PLAYLIST) videos[0]->setVolume(numUpdates % 2);
+    
+    // keep the load path busy too, except under a playlist
+    if(phase != PHASE_PLAYLIST && timeNow - lastLoadTime >= loadInterval){
+        lastLoadTime = timeNow;
+        int i = (int)ofRandom(videos.size());
+        videos[i]->loadMovie(phaseFiles->getPath(ofRandom(phaseFiles->size())));
+        videos[i]->play();
+    }
+    
+    if(timeNow - lastReport >= 1000){
+        ofxThreadedVideoBufferPool& buffers = ofxThreadedVideoBufferPool::getPool();
+        ofLogNotice() << getPhaseName(phase) << " " << framesSinceReport * 1000.0f / (timeNow - lastReport) << " frames/s, "
+                      << buffers.getBytesInUse() / 1024 << " KB of frame buffers in use, "
+                      << buffers.getNumAllocations() << " allocated " << buffers.getNumReuses() << " reused";
+        framesPresented += framesSinceReport;
+        framesSinceReport = 0;
+        lastReport = timeNow;
+    }
+    
+    if(timeNow - phaseStarted >= phaseSeconds * 1000) endPhase();
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+    for(int i = 0; i < videos.size(); i++){
+        delete videos[i];
+    }
+    videos.clear();
+}
+
+//--------------------------------------------------------------
+string ofApp::getPhaseName(Phase phase){
+    switch(phase){
+        case PHASE_THREAD_PER_INSTANCE:
+            return "thread per instance";
+        case PHASE_WORKER_POOL:
+            return "worker pool";
+        case PHASE_BACKEND_ON_WORKER:
+            return "backend on worker";
+        case PHASE_RAW_FRAMES:
+            return "raw frames (mmap)";
+        case PHASE_PLAYLIST:
+            return "playlist";
+        default:
+            return "done";
+    }
+}
+
+//--------------------------------------------------------------
+bool ofApp::checkCommandOrder(){
+    
+    // commands go in as the setters queue them, no instance needed
+    ofxThreadedVideoCommandLanes lanes;
+    bool bOk = true;
+    
+    // a batch goes in the control lane, which is claimed first, but
+    // mustn't overtake (and so be undone by) a transport command before it
+    ofxThreadedVideoCommand paused(VIDEO_COMMAND_SET_PAUSED, 0);
+    paused.args.paused = true;
+    lanes.push(paused);
+    lanes.beginBatch();
+    lanes.push(ofxThreadedVideoCommand(VIDEO_COMMAND_PLAY, 0));
+    lanes.endBatch();
+    bOk &= expectCommandOrder(lanes, "setPaused(1) play()", "setPaused() then a batch");
+    
+    // cosmetic commands still reach the movie they were meant for
+    ofxThreadedVideoCommand volume(VIDEO_COMMAND_SET_VOLUME, 0);
+    volume.args.value = 0.5f;
+    ofxThreadedVideoCommand load(VIDEO_COMMAND_LOAD, 0);
+    load.setPath("next.y4m");
+    lanes.push(volume);
+    lanes.push(load);
+    bOk &= expectCommandOrder(lanes, "setVolume(0.5) loadMovie(next.y4m)", "setVolume() then a load");
+    
+    // a seek meant for the old movie mustn't land on the first playlist item
+    ofxThreadedVideoCommand seek(VIDEO_COMMAND_SET_FRAME, 0);
+    seek.args.frame = 50;
+    ofxThreadedVideoCommand playlist(VIDEO_COMMAND_SET_PLAYLIST, 0);
+    playlist.args.frame = 1;
+    lanes.push(seek);
+    lanes.push(playlist);
+    bOk &= expectCommandOrder(lanes, "setPlaylist(1)", "setFrame() then a playlist");
+    
+    return bOk;
+}
+
+//--------------------------------------------------------------
+bool ofApp::expectCommandOrder(ofxThreadedVideoCommandLanes& lanes, string expected, string description){
+    
+    string claimed;
+    ofxThreadedVideoCommand c;
+    while(lanes.claimFront(c)){
+        claimed += (claimed.size() > 0 ? " " : "") + c.getCommandAsString();
+        lanes.pop();
+    }
+    
+    if(claimed != expected){
+        ofLogError() << "command order, " << description << ": ran " << claimed << ", expected " << expected;
+        return false;
+    }
+    ofLogNotice() << "command order, " << description << ": ok";
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::convertToRaw(string y4mPath, string rawPath){
+    
+    ofxThreadedVideoY4MPlayer player;
+    player.setPixelFormat(OF_PIXELS_BGRA);
+    if(!player.load(y4mPath)) return;
+    
+    ofxThreadedVideoRawWriter writer;
+    if(!writer.open(rawPath, player.getWidth(), player.getHeight(), OF_PIXELS_BGRA, player.getFrameRate())) return;
+    
+    for(int i = 0; i < player.getTotalNumFrames(); i++){
+        player.setFrame(i);
+        player.update();
+        writer.addFrame(player.getPixels());
+    }
+    writer.close();
+    
+    ofLogNotice() << "converted " << y4mPath << " to " << rawPath << " (" << writer.getNumFrames() << " frames)";
+}
+
+//--------------------------------------------------------------
+bool ofApp::writeCounterClip(string path, int firstFrame, int numFrames){
+    
+    // every frame is flat grey, its luma 32 + its place in the playlist so
+    // black (16 in a clip, 0 from the engine) can't pass for one
+    int width = 64;
+    int height = 64;
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    if(!file.is_open()){
+        ofLogError() << "couldn't write " << path;
+        return false;
+    }
+    file << "YUV4MPEG2 W" << width << " H" << height << " F30:1 Ip A1:1 C420jpeg\n";
+    vector<char> chroma(width * height / 2, (char)128);
+    for(int i = 0; i < numFrames; i++){
+        vector<char> luma(width * height, (char)(32 + firstFrame + i));
+        file << "FRAME\n";
+        file.write(&luma[0], luma.size());
+        file.write(&chroma[0], chroma.size());
+    }
+    return file.good();
+}
+
+//--------------------------------------------------------------
+void ofApp::checkPlaylistFrame(int i){
+    
+    PlaylistCheck& check = playlistChecks[i];
+    unsigned char * pixels = videos[i]->getPixels();
+    int frame = pixels != NULL ? pixels[0] - 32 : -1;
+    check.numFrames++;
+    
+    if(frame < 0 || frame >= numPlaylistFrames){
+        check.numBlack++;
+        return;
+    }
+    
+    // the first frame can be anywhere, it's the steps after that count
+    if(check.lastFrame >= 0){
+        int expected = (check.lastFrame + 1) % numPlaylistFrames;
+        if(frame == check.lastFrame){
+            check.numRepeated++;
+        }else if(frame != expected){
+            check.numSkipped++;
+            if(expected % (numPlaylistFrames / playlist.size()) == 0) check.numSkippedJoins++;
+        }
+    }
+    check.lastFrame = frame;
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkConvert(int width, int height){
+    
+    // random pixels so nothing gets to sit in a flat colour
+    ofPixels source;
+    source.allocate(width, height, OF_PIXELS_YUY2);
+    unsigned char * data = source.getPixels();
+    for(int i = 0; i < width * height * 2; i++){
+        data[i] = ofRandom(256);
+    }
+    
+    ofPixels converted;
+    
+    ofPixels swizzleSource, swizzled;
+    swizzleSource.allocate(width, height, OF_PIXELS_RGBA);
+    swizzled.allocate(width, height, OF_PIXELS_RGBA);
+    data = swizzleSource.getPixels();
+    for(int i = 0; i < width * height * 4; i++){
+        data[i] = ofRandom(256);
+    }
+    ofxThreadedVideoSwizzleType swizzles[] = {SWIZZLE_ARGB_TO_RGB, SWIZZLE_RGBA_TO_RGB, SWIZZLE_BGRA_TO_RGBA};
+    string swizzleNames[] = {"ARGB to RGB", "RGBA to RGB", "BGRA to RGBA"};
+    ofPixelFormat formats[] = {OF_PIXELS_RGB, OF_PIXELS_RGBA, OF_PIXELS_BGRA};
+    string formatNames[] = {"RGB", "RGBA", "BGRA"};
+    ofxThreadedVideoConvertKernel kernels[] = {CONVERT_KERNEL_SCALAR, CONVERT_KERNEL_SSE2, CONVERT_KERNEL_AVX2};
+    int numFrames = 30;
+    
+    // the kernels on their own first, one thread
+    ofxThreadedVideoConvert::setNumSlices(1);
+    
+    for(int k = 0; k < 3; k++){
+        
+        if(!ofxThreadedVideoConvert::isKernelSupported(kernels[k])){
+            ofLogNotice() << "convert " << width << "x" << height << " " << ofxThreadedVideoConvert::getKernelName(kernels[k]) << ": not supported";
+            continue;
+        }
+        ofxThreadedVideoConvert::setKernel(kernels[k]);
+        
+        for(int f = 0; f < 3; f++){
+            // first one allocates the destination
+            ofxThreadedVideoConvert::yuy2ToPixels(source, converted, formats[f]);
+            unsigned long long timeStart = ofGetElapsedTimeMicros();
+            for(int i = 0; i < numFrames; i++){
+                ofxThreadedVideoConvert::yuy2ToPixels(source, converted, formats[f]);
+            }
+            unsigned long long micros = ofGetElapsedTimeMicros() - timeStart;
+            ofLogNotice() << "convert " << width << "x" << height << " " << ofxThreadedVideoConvert::getKernelName(kernels[k]) << " to " << formatNames[f] << ": "
+                          << (double)width * height * numFrames / MAX(micros, 1) << " Mpixels/s";
+        }
+        
+        // and the plain swizzles, with and without the flip
+        for(int t = 0; t < 3; t++){
+            for(int flip = 0; flip < 2; flip++){
+                int bytesPerPixel = swizzles[t] == SWIZZLE_BGRA_TO_RGBA ? 4 : 3;
+                unsigned long long timeStart = ofGetElapsedTimeMicros();
+                for(int i = 0; i < numFrames; i++){
+                    ofxThreadedVideoConvert::swizzlePixels(swizzleSource.getPixels(), width * 4, swizzled.getPixels(), width * bytesPerPixel, width, height, swizzles[t], flip == 1);
+                }
+                unsigned long long micros = ofGetElapsedTimeMicros() - timeStart;
+                ofLogNotice() << "swizzle " << width << "x" << height << " " << ofxThreadedVideoConvert::getKernelName(kernels[k]) << " " << swizzleNames[t] << (flip == 1 ? " flipped" : "") << ": "
+                              << (double)width * height * numFrames / MAX(micros, 1) << " Mpixels/s";
+            }
+        }
+        
+        // and the thumbnail downscale, to a tenth of the width like the benchmark's tiles
+        ofPixels scaled;
+        unsigned long long timeStart = ofGetElapsedTimeMicros();
+        for(int i = 0; i < numFrames; i++){
+            ofxThreadedVideoConvert::scalePixels(swizzleSource, scaled, width / 10, height / 10);
+        }
+        float millis = (ofGetElapsedTimeMicros() - timeStart) / 1000.0f / numFrames;
+        ofLogNotice() << "scale " << width << "x" << height << " " << ofxThreadedVideoConvert::getKernelName(kernels[k]) << " RGBA to "
+                      << scaled.getWidth() << "x" << scaled.getHeight() << ": " << millis << " ms per frame";
+        
+    }
+    
+    ofxThreadedVideoConvert::setKernel(CONVERT_KERNEL_AUTO);
+    
+    // then the per frame latency with the rows split across the conversion
+    // threads, against doing the whole frame on this thread. on a single
+    // core the slices just take turns, so say so next to the numbers
+    int numCores = thread::hardware_concurrency();
+    ofLogNotice() << "convert slices on " << numCores << " cores, " << ofxThreadedVideoConvert::getNumThreads() << " conversion threads"
+                  << (numCores <= 1 ? " (single core: slices can't run in parallel here)" : "");
+    int numSlices[] = {1, 2, 4, 0};
+    float singleMillis = 0;
+    for(int n = 0; n < 4; n++){
+        ofxThreadedVideoConvert::setNumSlices(numSlices[n]);
+        ofxThreadedVideoConvert::yuy2ToPixels(source, converted, OF_PIXELS_BGRA);
+        unsigned long long timeStart = ofGetElapsedTimeMicros();
+        for(int i = 0; i < numFrames; i++){
+            ofxThreadedVideoConvert::yuy2ToPixels(source, converted, OF_PIXELS_BGRA);
+        }
+        float millis = (ofGetElapsedTimeMicros() - timeStart) / 1000.0f / numFrames;
+        if(numSlices[n] == 1) singleMillis = millis;
+        ofLogNotice() << "convert " << width << "x" << height << " " << ofxThreadedVideoConvert::getKernelName(ofxThreadedVideoConvert::getActiveKernel()) << " to BGRA in "
+                      << ofxThreadedVideoConvert::getNumSlices(width, height) << (numSlices[n] == 0 ? " slices (auto): " : " slices: ")
+                      << millis << " ms per frame (" << singleMillis / MAX(millis, 0.001f) << "x)";
+    }
+}
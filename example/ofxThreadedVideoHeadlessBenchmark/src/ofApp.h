@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxThreadedVideo.h"
+
+// runs the whole engine (queues, workers, decode ahead, buffer pool) with
+// the Y4M backend and no window, so it can be benchmarked on build servers.
+// put some .y4m clips in bin/data/media, eg.:
+//   ffmpeg -i clip.mov -t 20 -pix_fmt yuv420p bin/data/media/clip.y4m
+// the clips are also converted once to raw frame files in bin/data/media/raw
+// for the raw frames phase, which plays them memory mapped with no decoding.
+// each phase runs the same number of instances for phaseSeconds and prints
+// presented frames/sec and the time spent in update(), then the p50/p99
+// enqueue -> execute latency of the setVolume() pushed to the first
+// instance on every update. the last phase writes a few clips whose
+// frames count up, plays them as a looping playlist and checks no black
+// or repeated frames show at the joins; then the app exits, with an
+// error if any did.
+// before any of that the cpu YUY2 converter and swizzles are timed on their
+// own (they need no media) and Mpixels/s is printed for every kernel at
+// 1080p and 4K, followed by the per frame latency of splitting the frame
+// across the conversion threads. first of all the command lanes are checked
+// to hand out commands in an order that ends in the state asked for; the
+// app exits with an error if they don't
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void exit();
+
+        enum Phase {
+            PHASE_THREAD_PER_INSTANCE = 0,
+            PHASE_WORKER_POOL,
+            PHASE_BACKEND_ON_WORKER,
+            PHASE_RAW_FRAMES,
+            PHASE_PLAYLIST,
+            PHASE_DONE
+        };
+    
+        void startPhase(Phase phase);
+        void endPhase();
+        string getPhaseName(Phase phase);
+    
+        bool checkCommandOrder();
+        bool expectCommandOrder(ofxThreadedVideoCommandLanes& lanes, string expected, string description);
+    
+        void convertToRaw(string y4mPath, string rawPath);
+        bool writeCounterClip(string path, int firstFrame, int numFrames);
+        void checkPlaylistFrame(int i);
+    
+        // what one playlist instance has presented so far
+        struct PlaylistCheck {
+            int lastFrame;
+            int numFrames, numBlack, numRepeated, numSkipped, numSkippedJoins;
+        };
+    
+        void benchmarkConvert(int width, int height);
+    
+        ofDirectory files;
+        ofDirectory rawFiles;
+        ofDirectory * phaseFiles;
+        vector<ofxThreadedVideo*> videos;
+        vector<string> playlist;
+        vector<PlaylistCheck> playlistChecks;
+        int numPlaylistFrames;
+        bool bPlaylistFailed;
+    
+        int numVideos;
+        int phaseSeconds;
+        int loadInterval;
+    
+        Phase phase;
+        unsigned long long phaseStarted, lastLoadTime, lastReport;
+        unsigned long long updateMicros, framesPresented, numUpdates;
+        unsigned long long framesSinceReport;
+
+};
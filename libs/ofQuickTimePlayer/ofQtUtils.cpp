@@ -3,6 +3,7 @@
 #if (defined (TARGET_WIN32) || (defined TARGET_OSX)) && (defined(OF_VIDEO_CAPTURE_QUICKTIME) || defined(OF_VIDEO_PLAYER_QUICKTIME))
 #include "ofUtils.h"
 #include "ofGraphics.h"
+#include "ofxThreadedVideoConvert.h"
 static bool bQuicktimeInitialized = false;
 
 //----------------------------------------
@@ -49,13 +50,6 @@ void closeQuicktime(){
 //----------------------------------------
 void convertPixels(unsigned char * gWorldPixels, unsigned char * rgbPixels, int w, int h){
 
-	// ok for macs?
-	// ok for intel macs?
-
-	int * rgbaPtr 			= (int *) gWorldPixels;
-	pix24 * rgbPtr 			= (pix24 *) rgbPixels;
-		unsigned char * rgbaStart;
-
 	//	putting in the boolean, so we can work on
 	//	0,0 in top right...
 	//	bool bFlipVertically 	= true;
@@ -70,29 +64,9 @@ void convertPixels(unsigned char * gWorldPixels, unsigned char * rgbPixels, int
 	// it will be upside-down....
 	// -------------------------------------------
 
-	if (!bFlipVertically){
-		//----- argb->rgb
-		for (int i = 0; i < h; i++){
-			pix24 * rgbPtr 			= (pix24 *) rgbPixels + ((i) * w);
-			for (int j = 0; j < w; j++){
-				rgbaStart = (unsigned char *)rgbaPtr;
-				memcpy (rgbPtr, rgbaStart+1, sizeof(pix24));
-				rgbPtr++;
-				rgbaPtr++;
-			}
-		}
-	} else {
-		//----- flip while argb->rgb
-		for (int i = 0; i < h; i++){
-			pix24 * rgbPtr 			= (pix24 *) rgbPixels + ((h-i-1) * w);
-			for (int j = 0; j < w; j++){
-				rgbaStart = (unsigned char *)rgbaPtr;
-				memcpy (rgbPtr, rgbaStart+1, sizeof(pix24));
-				rgbPtr++;
-				rgbaPtr++;
-			}
-		}
-	}
+	//----- argb->rgb, flipping in the same pass if asked to
+	//----- (SSE2/AVX2 when the cpu has them)
+	ofxThreadedVideoConvert::swizzlePixels(gWorldPixels, w * 4, rgbPixels, w * 3, w, h, SWIZZLE_ARGB_TO_RGB, bFlipVertically);
 }
 
 
@@ -339,23 +339,8 @@ bool ofQuickTimePlayer::load(string name){
 	    myDrawCompleteProc = NewMovieDrawingCompleteUPP (DrawCompleteProc);
 		SetMovieDrawingCompleteProc (moviePtr, movieDrawingCallWhenChanged,  myDrawCompleteProc, (long)this);
 
-		// ------------- get the total # of frames:
-		nFrames				= 0;
-		TimeValue			curMovieTime;
-		curMovieTime		= 0;
-		TimeValue			duration;
-
-		//OSType whichMediaType	= VIDEO_TYPE; // mingw chokes on this
-		OSType whichMediaType	= FOUR_CHAR_CODE('vide');
-
-		short flags				= nextTimeMediaSample + nextTimeEdgeOK;
-
-		while( curMovieTime >= 0 ) {
-			nFrames++;
-			GetMovieNextInterestingTime(moviePtr,flags,1,&whichMediaType,curMovieTime,0,&curMovieTime,&duration);
-			flags = nextTimeMediaSample;
-		}
-		nFrames--; // there's an extra time step at the end of themovie
+		// ------------- get the total # of frames and when each one starts:
+		buildFrameIndex();
 
 
 
@@ -598,13 +583,21 @@ void ofQuickTimePlayer::setFrame(int frame){
 
 	if (!bPaused) SetMovieRate(moviePtr, X2Fix(0));
 
+	// exact, even for variable frame rates, when we have the sample times
+	TimeValue frameTime = getTimeForFrame(frame);
+
 	// this is better with mpeg, etc:
 	double frameRate = 0;
 	double movieTimeScale = 0;
-	MovieGetStaticFrameRate(moviePtr, &frameRate);
-	movieTimeScale = GetMovieTimeScale(moviePtr);
+	if (frameTime < 0){
+		MovieGetStaticFrameRate(moviePtr, &frameRate);
+		movieTimeScale = GetMovieTimeScale(moviePtr);
+	}
 
-	if (frameRate > 0){
+	if (frameTime >= 0){
+		SetMovieTimeValue(moviePtr, frameTime);
+		MoviesTask(moviePtr, 0);
+	}else if (frameRate > 0){
 		double frameDuration = 1 / frameRate;
 		TimeValue t = (TimeValue)(frame * frameDuration * movieTimeScale);
 		SetMovieTimeValue(moviePtr, t);
@@ -673,8 +666,10 @@ int ofQuickTimePlayer::getCurrentFrame() const{
 	#ifdef OF_VIDEO_PLAYER_QUICKTIME
 	//--------------------------------------
 
-	int frame = 0;
+	int frame = getFrameForTime(GetMovieTime(moviePtr, nil));
+	if (frame >= 0) return frame;
 
+	// no index, estimate from the position
 	// zach I think this may fail on variable length frames...
 	float pos = getPosition();
 
@@ -838,6 +833,116 @@ void ofQuickTimePlayer::setPaused(bool _bPause){
 
 
 
+//---------------------------------------------------------------------------
+void ofQuickTimePlayer::buildFrameIndex(){
+
+	//--------------------------------------
+	#ifdef OF_VIDEO_PLAYER_QUICKTIME
+	//--------------------------------------
+
+	frameIndex.clear();
+
+	nFrames				= 0;
+	TimeValue			curMovieTime;
+	curMovieTime		= 0;
+	TimeValue			duration;
+
+	//OSType whichMediaType	= VIDEO_TYPE; // mingw chokes on this
+	OSType whichMediaType	= FOUR_CHAR_CODE('vide');
+
+	short flags				= nextTimeMediaSample + nextTimeEdgeOK;
+
+	while( curMovieTime >= 0 ) {
+		nFrames++;
+		GetMovieNextInterestingTime(moviePtr,flags,1,&whichMediaType,curMovieTime,0,&curMovieTime,&duration);
+		if( curMovieTime >= 0 ) addFrameToIndex(curMovieTime);
+		flags = nextTimeMediaSample;
+	}
+	nFrames--; // there's an extra time step at the end of themovie
+
+	//--------------------------------------
+	#endif
+	//--------------------------------------
+
+}
+
+//---------------------------------------------------------------------------
+void ofQuickTimePlayer::addFrameToIndex(TimeValue time){
+
+	// frames that follow on at the same interval extend the current run,
+	// so constant frame rate media is a single entry however long it is
+	if( frameIndex.size() > 0 ){
+		ofQuickTimeFrameRun & run = frameIndex.back();
+		if( run.numFrames == 1 && time > run.time ){
+			run.duration = time - run.time;
+			run.numFrames++;
+			return;
+		}
+		if( time == run.time + run.numFrames * run.duration ){
+			run.numFrames++;
+			return;
+		}
+	}
+
+	ofQuickTimeFrameRun run;
+	run.frame		= frameIndex.size() > 0 ? frameIndex.back().frame + frameIndex.back().numFrames : 0;
+	run.time		= time;
+	run.duration	= 0;
+	run.numFrames	= 1;
+	frameIndex.push_back(run);
+
+}
+
+//---------------------------------------------------------------------------
+int ofQuickTimePlayer::getFrameForTime(TimeValue time) const{
+
+	if( frameIndex.size() == 0 ) return -1;
+
+	// last run starting at or before time
+	int lo = 0;
+	int hi = frameIndex.size() - 1;
+	while( lo < hi ){
+		int mid = (lo + hi + 1) / 2;
+		if( frameIndex[mid].time <= time ){
+			lo = mid;
+		}else{
+			hi = mid - 1;
+		}
+	}
+
+	const ofQuickTimeFrameRun & run = frameIndex[lo];
+	if( time <= run.time || run.duration <= 0 ) return run.frame;
+	int offset = (time - run.time) / run.duration;
+	if( offset > run.numFrames - 1 ) offset = run.numFrames - 1;
+	return run.frame + offset;
+
+}
+
+//---------------------------------------------------------------------------
+TimeValue ofQuickTimePlayer::getTimeForFrame(int frame) const{
+
+	if( frameIndex.size() == 0 ) return -1;
+
+	// last run starting at or before frame
+	int lo = 0;
+	int hi = frameIndex.size() - 1;
+	while( lo < hi ){
+		int mid = (lo + hi + 1) / 2;
+		if( frameIndex[mid].frame <= frame ){
+			lo = mid;
+		}else{
+			hi = mid - 1;
+		}
+	}
+
+	const ofQuickTimeFrameRun & run = frameIndex[lo];
+	int offset = frame - run.frame;
+	if( offset < 0 ) offset = 0;
+	if( offset > run.numFrames - 1 ) offset = run.numFrames - 1;
+	return run.time + offset * run.duration;
+
+}
+
 //---------------------------------------------------------------------------
 void ofQuickTimePlayer::clearMemory(){
 
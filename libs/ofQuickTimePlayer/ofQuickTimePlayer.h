@@ -67,6 +67,22 @@ class ofQuickTimePlayer : public ofBaseVideoPlayer{
 		virtual void createImgMemAndGWorld();
 		void start();
 
+		// walks every video sample once on load to count the frames and
+		// record when each starts; override to fill frameIndex some other way
+		virtual void buildFrameIndex();
+		void addFrameToIndex(TimeValue time);	// in sample order
+		int getFrameForTime(TimeValue time) const;	// -1 if there's no index
+		TimeValue getTimeForFrame(int frame) const;	// -1 if there's no index
+
+		// runs of frames spaced duration apart, ie., one entry for constant frame rates
+		struct ofQuickTimeFrameRun {
+			int			frame;
+			TimeValue	time;
+			TimeValue	duration;
+			int			numFrames;
+		};
+		vector<ofQuickTimeFrameRun> frameIndex;
+
 		ofPixels		 	pixels;
 		int					width, height;
 		bool				bLoaded;
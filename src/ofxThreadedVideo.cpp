@@ -31,15 +31,70 @@
 
 #include "ofxThreadedVideo.h"
 
+//--------------------------------------------------------------
+ofxThreadedVideoState ofxThreadedVideo::getState(){
+    return publishedState.load();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::publishState(){
+    // callers hold the mutex, which is what keeps this single writer
+    ofxThreadedVideoState state;
+    state.width = width;
+    state.height = height;
+    state.duration = duration;
+    state.speed = speed;
+    state.position = position;
+    state.volume = volume;
+    state.pan = pan;
+    state.fade = fade;
+    state.loopState = loopState;
+    state.pixelFormat = internalPixelFormat;
+    state.frameCurrent = frameCurrent;
+    state.frameTotal = frameTotal;
+    state.frameRate = frameRate;
+    state.bLoaded = bLoaded;
+    state.bIsLoading = bIsLoading;
+    state.bIsPlaying = bIsPlaying;
+    state.bIsPaused = bIsPaused;
+    state.bIsMovieDone = bIsMovieDone;
+    state.bIsTextureReady = bIsTextureReady;
+    publishedState.store(state);
+}
+
 //--------------------------------------------------------------
 void ofxThreadedVideo::flush(){
     lock();
-    ofxThreadedVideoGlobalMutex.lock();
-    ofxThreadedVideoCommands.clear();
-    ofxThreadedVideoGlobalMutex.unlock();
+    // only the current consumer may move the head, so if a command
+    // is executing right now the clear is deferred until it's done
+    if(bCriticalSection){
+        bFlushPending = true;
+    }else{
+        ofxThreadedVideoCommands.clear();
+        groupRemaining = 0;
+    }
     unlock();
 }
 
+//--------------------------------------------------------------
+void ofxThreadedVideo::beginBatch(){
+    if(ofxThreadedVideoCommands.isBatching()){
+        ofLogWarning() << instanceID << " beginBatch() called twice, the earlier commands are part of this batch";
+        return;
+    }
+    ofxThreadedVideoCommands.beginBatch();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::endBatch(){
+    if(!ofxThreadedVideoCommands.isBatching()) return;
+    if(!ofxThreadedVideoCommands.endBatch()){
+        ofLogError() << instanceID << " command queue full (" << OFX_THREADED_VIDEO_QUEUE_SIZE << ") dropping batch";
+        return;
+    }
+    signalWorker();
+}
+
 //--------------------------------------------------------------
 void ofxThreadedVideo::finish(){
     while(getQueueSize() > 0){
@@ -50,10 +105,328 @@ void ofxThreadedVideo::finish(){
 
 //--------------------------------------------------------------
 int ofxThreadedVideo::getQueueSize(){
-//    ofScopedLock lock(ofxThreadedVideoGlobalMutex);
     return ofxThreadedVideoCommands.size();
 }
 
+//--------------------------------------------------------------
+float ofxThreadedVideo::getCommandLatency(float percentile){
+    vector<float> samples;
+    lock();
+    int numSamples = MIN(commandLatencyCount, OFX_THREADED_VIDEO_LATENCY_SAMPLES);
+    samples.assign(commandLatency, commandLatency + numSamples);
+    unlock();
+    if(samples.size() == 0) return 0.0f;
+    int index = CLAMP((int)(percentile * (samples.size() - 1) + 0.5f), 0, (int)samples.size() - 1);
+    nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getQueueOverflow(){
+    return ofxThreadedVideoCommands.getOverflowCount();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getQueueCoalesced(){
+    return ofxThreadedVideoCommands.getCoalescedCount();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getQueueCancelled(){
+    return ofxThreadedVideoCommands.getCancelledCount();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setDecodeAhead(int numFrames){
+    decodeAheadFrames = MAX(0, numFrames);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getDecodeAhead(){
+    return decodeAheadFrames;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getDecodeAheadOccupancy(){
+    return decodeAheadOccupancy;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getDecodeAheadUnderruns(){
+    return decodeAheadUnderruns;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getDecodeAheadDropped(){
+    return decodeAheadDropped;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setBackendOnWorker(bool b){
+    bBackendOnWorker = b;
+    signalWorker();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::getBackendOnWorker(){
+    return bBackendOnWorker;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setConvertPixelFormat(ofPixelFormat pixelFormat){
+    if(pixelFormat != OF_PIXELS_UNKNOWN && !ofxThreadedVideoConvert::isPixelFormatSupported(pixelFormat)){
+        ofLogWarning() << "Can only convert YUY2 frames to RGB, RGBA or BGRA";
+        return;
+    }
+    convertPixelFormat = pixelFormat;
+}
+
+//--------------------------------------------------------------
+ofPixelFormat ofxThreadedVideo::getConvertPixelFormat(){
+    return (ofPixelFormat)convertPixelFormat.load();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setOutputSize(int width, int height){
+    outputWidth = MAX(width, 0);
+    outputHeight = MAX(height, 0);
+    signalWorker();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getOutputWidth(){
+    return outputWidth;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getOutputHeight(){
+    return outputHeight;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setPlayerOutputSize(ofPtr<ofBaseVideoPlayer> player, int width, int height){
+    // only backends that can decode to size know about it
+    ofxThreadedVideoOutputSize * sizedPlayer = dynamic_cast<ofxThreadedVideoOutputSize*>(player.get());
+    if(sizedPlayer != NULL) sizedPlayer->setOutputSize(width, height);
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideo::getFrameDurationMillis(){
+    if(frameTotal > 0 && duration > 0.0f) return duration * 1000.0f / frameTotal;
+    return 1000.0f / 30.0f;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::decodeAhead(int videoID, bool bPresentForced, bool bPrerolled){
+    
+    // with the backend on the worker seeks and black stops come through
+    // here too, and go straight to the front of the ring
+    bool bForce = false;
+    bool bBlack = false;
+    if(bPresentForced){
+        lock();
+        bForce = bForceFrameNew;
+        bBlack = bForceBlack;
+        unlock();
+        if(bBlack && !bForce) return;
+    }
+    
+    // a prerolled playlist item already holds its first frame, which the
+    // backend won't call new again once it's playing
+    if(!bBlack && !bPrerolled) video[videoID].update();
+    if(!bForce && !bPrerolled && !video[videoID].isFrameNew()) return;
+    if(bForce) clearDecodedFrames();
+    
+    ofPixels& source = video[videoID].getPixelsRef();
+    int numFrames = decodeAheadFrames;
+    
+    // YUV frames can be converted on their way into the ring
+    ofPixelFormat framePixelFormat = source.getPixelFormat();
+    ofPixelFormat convertFormat = (ofPixelFormat)convertPixelFormat.load();
+    bool bConvert = ofxThreadedVideoConvert::isYUVPixelFormat(framePixelFormat) && convertFormat != OF_PIXELS_UNKNOWN;
+    if(bConvert) framePixelFormat = convertFormat;
+    
+    // anything bigger than the output size is scaled down first, so a
+    // conversion only has the small frame to do
+    int frameWidth = source.getWidth();
+    int frameHeight = source.getHeight();
+    bool bScale = ofxThreadedVideoConvert::isScaleSupported(source.getPixelFormat()) &&
+                  ofxThreadedVideoConvert::getScaledSize(frameWidth, frameHeight, outputWidth, outputHeight, frameWidth, frameHeight);
+    if(bScale && !bBlack && !ofxThreadedVideoConvert::scalePixels(source, scaledPixels, frameWidth, frameHeight)){
+        // the full size frame is still better than none
+        ofLogError("ofxThreadedVideo") << "Couldn't scale " << source.getWidth() << "x" << source.getHeight() << " to " << frameWidth << "x" << frameHeight;
+        bScale = false;
+        frameWidth = source.getWidth();
+        frameHeight = source.getHeight();
+    }
+    
+    // numFrames waiting + the one update() is presenting + the one we're writing
+    if(frameBuffers.size() != numFrames + 2 ||
+       frameBuffers[0]->getWidth() != frameWidth ||
+       frameBuffers[0]->getHeight() != frameHeight ||
+       frameBuffers[0]->getPixelFormat() != framePixelFormat){
+        releaseFrameBuffers();
+        for(int i = 0; i < numFrames + 2; i++){
+            ofPixels * buffer = new ofPixels;
+            frameBuffers.push_back(buffer);
+            if(!ofxThreadedVideoBufferPool::getPool().acquire(*buffer, frameWidth, frameHeight, framePixelFormat)){
+                releaseFrameBuffers();
+                return;
+            }
+            freeFrameBuffers.push_back(buffer);
+        }
+    }
+    
+    if(freeFrameBuffers.size() == 0){
+        // update() isn't keeping up - drop the oldest frame rather than stall the backend
+        freeFrameBuffers.push_back(decodedFrames.front().pixels);
+        decodedFrames.pop_front();
+        decodeAheadDropped++;
+    }
+    
+    ofxThreadedVideoFrame frame;
+    frame.pixels = freeFrameBuffers.back();
+    freeFrameBuffers.pop_back();
+    
+    if(bBlack){
+        frame.pixels->set(0);
+    }else if(bScale && bConvert){
+        ofxThreadedVideoConvert::yuvToPixels(scaledPixels, *frame.pixels, framePixelFormat);
+    }else if(bScale){
+        memcpy(frame.pixels->getPixels(), scaledPixels.getPixels(), scaledPixels.getTotalBytes());
+    }else if(bConvert){
+        ofxThreadedVideoConvert::yuvToPixels(source, *frame.pixels, framePixelFormat);
+    }else{
+        memcpy(frame.pixels->getPixels(), source.getPixels(), source.getTotalBytes());
+    }
+    frame.frameCurrent = video[videoID].getCurrentFrame();
+    frame.position = video[videoID].getPosition();
+    frame.bIsMovieDone = video[videoID].getIsMovieDone();
+    frame.bBlack = bBlack;
+    frame.timeDue = ofGetElapsedTimeMicros();
+    if(!bForce) frame.timeDue += (unsigned long long)(numFrames * getFrameDurationMillis() * 1000.0f);
+    
+    decodedFrames.push_back(frame);
+    decodeAheadOccupancy = decodedFrames.size();
+    
+    if(bForce){
+        lock();
+        bForceFrameNew = false;
+        unlock();
+    }
+    
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoFrame * ofxThreadedVideo::presentDecodedFrame(){
+    
+    unsigned long long timeNow = ofGetElapsedTimeMicros();
+    
+    if(decodedFrames.size() == 0 || decodedFrames.front().timeDue > timeNow){
+        // count each gap once and only while we're actually expecting frames
+        if(!bUnderrun && bIsPlaying && !bIsPaused && timeLastPresented != 0 &&
+           timeNow - timeLastPresented > getFrameDurationMillis() * 1500.0f){
+            decodeAheadUnderruns++;
+            bUnderrun = true;
+        }
+        return NULL;
+    }
+    
+    // take the newest frame that's due, recycling any we're too late for
+    if(presentedFrame.pixels != NULL) freeFrameBuffers.push_back(presentedFrame.pixels);
+    presentedFrame = decodedFrames.front();
+    decodedFrames.pop_front();
+    while(decodedFrames.size() > 0 && decodedFrames.front().timeDue <= timeNow){
+        freeFrameBuffers.push_back(presentedFrame.pixels);
+        presentedFrame = decodedFrames.front();
+        decodedFrames.pop_front();
+        decodeAheadDropped++;
+    }
+    
+    decodeAheadOccupancy = decodedFrames.size();
+    timeLastPresented = timeNow;
+    bUnderrun = false;
+    
+    return &presentedFrame;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::clearDecodedFrames(){
+    for(int i = 0; i < decodedFrames.size(); i++) freeFrameBuffers.push_back(decodedFrames[i].pixels);
+    decodedFrames.clear();
+    decodeAheadOccupancy = 0;
+    timeLastPresented = 0;
+    bUnderrun = false;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::releaseFrameBuffers(){
+    lock();
+    if(presentedFrame.pixels != NULL && pixels == presentedFrame.pixels) pixels = &video[currentVideoID].getPixelsRef();
+    unlock();
+    decodedFrames.clear();
+    freeFrameBuffers.clear();
+    for(int i = 0; i < frameBuffers.size(); i++){
+        if(frameBuffers[i]->isAllocated()) ofxThreadedVideoBufferPool::getPool().release(*frameBuffers[i]);
+        delete frameBuffers[i];
+    }
+    frameBuffers.clear();
+    presentedFrame.pixels = NULL;
+    decodeAheadOccupancy = 0;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::bUseWorkerPool = false;
+int ofxThreadedVideo::workerPoolThreads = 0;
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setUseWorkerPool(bool b, int numThreads){
+    bUseWorkerPool = b;
+    workerPoolThreads = numThreads;
+    // backends that share the pool (image sequences) may set it up first
+    ofxThreadedVideoPool::getPool().setDefaultNumThreads(numThreads);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::getUseWorkerPool(){
+    return bUseWorkerPool;
+}
+
+//--------------------------------------------------------------
+ofMutex ofxThreadedVideo::backendMutex;
+condition_variable ofxThreadedVideo::backendCondition;
+int ofxThreadedVideo::backendLimit = 0;
+int ofxThreadedVideo::backendActive = 0;
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setGlobalBackendLimit(int maxConcurrent){
+    ofScopedLock lock(backendMutex);
+    backendLimit = MAX(maxConcurrent, 0);
+    backendCondition.notify_all();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getGlobalBackendLimit(){
+    ofScopedLock lock(backendMutex);
+    return backendLimit;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::lockBackend(){
+    ofScopedLock lock(backendMutex);
+    while(backendLimit > 0 && backendActive >= backendLimit){
+        backendCondition.wait(lock);
+    }
+    backendActive++;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::unlockBackend(){
+    ofScopedLock lock(backendMutex);
+    backendActive--;
+    backendCondition.notify_one();
+}
+
 //--------------------------------------------------------------
 int ofxThreadedVideo::getLoadOk(){
     return ofxThreadedVideoLoadOk;
@@ -70,9 +443,30 @@ ofxThreadedVideo::ofxThreadedVideo(){
     instanceID = ofxThreadedVideoGlobalInstanceID;
     ofxThreadedVideoGlobalInstanceID++;
     
+#if OFX_THREADED_VIDEO_USE_QUICKTIME
     initializeQuicktime();
+#endif
+    
+    preloadCacheSlots = 0;
+    preloadCacheBytes = 0;
+    preloadHits = 0;
+    preloadMisses = 0;
     
+    nextPlaylistID = 0;
+    playlistIndex = 0;
+    playlistGeneration = 0;
+    prerollID = -1;
+    prerollIndex = 0;
+    bPlaylistLoop = false;
+    bPlaylistStarting = false;
+    
+#if OFX_THREADED_VIDEO_USE_QUICKTIME
     setPlayer<ofQuickTimePlayerWithFastPixels>();
+#else
+    // no QuickTime here so start with the platform's player; headless and
+    // benchmark builds usually setPlayer<ofxThreadedVideoY4MPlayer>() instead
+    setPlayer<OF_VID_PLAYER_TYPE>();
+#endif
     
     // setup video instances
     video[0].setUseTexture(false);
@@ -82,22 +476,41 @@ ofxThreadedVideo::ofxThreadedVideo(){
     
     bUseInternalShader = false;
     
-    drawTexture.allocate(1, 1, GL_RGB);
-    ofPixels p;
-    p.allocate(1, 1, OF_IMAGE_COLOR);
-    p.set(0);
-    drawTexture.loadData(p.getPixels(), 1, 1, GL_RGB);
+    // the black placeholder texture is made on the first update() so an
+    // instance can be created (and setUseTexture(false)) without a GL context
     pixels = &video[0].getPixelsRef();
     
     // set vars to default values
     currentVideoID = VIDEO_FLIP;
     bCriticalSection = false;
+    bFlushPending = false;
+    bCommandClaimed = false;
+    groupRemaining = 0;
+    
+    handles = ofPtr<ofxThreadedVideoHandleTable>(new ofxThreadedVideoHandleTable);
+    ofxThreadedVideoCommands.setHandleTable(handles.get());
+    
+    decodeAheadFrames = 0;
+    decodeAheadOccupancy = 0;
+    decodeAheadUnderruns = 0;
+    decodeAheadDropped = 0;
+    presentedFrame.pixels = NULL;
+    timeLastPresented = 0;
+    bUnderrun = false;
+    bBackendOnWorker = false;
+    convertPixelFormat = OF_PIXELS_UNKNOWN;
+    outputWidth = 0;
+    outputHeight = 0;
+    texturePixelFormat = OF_PIXELS_UNKNOWN;
+    bTextureConverted = false;
+    bPlanarTexture = false;
     bLoaded = false;
     
 	bUseBlackStop = bForceBlack = false;
     bUseTexture = true;
     bIsFrameNew = false;
     bIsPlaying = false;
+    bIsTextureReady = false;
     bIsLoading = false;
     bIsMovieDone = false;
     
@@ -125,82 +538,178 @@ ofxThreadedVideo::ofxThreadedVideo(){
     prevMillis = ofGetElapsedTimeMillis();
     lastFrameTime = timeNow = timeThen = fps = frameRate = 0;
     
-    ofxThreadedVideoNullCommand.setCommand("NULL_COMMAND", -1);
+    ofxThreadedVideoNullCommand.setCommand(VIDEO_COMMAND_NULL, -1);
     
     bVerbose = false;
     
+    bWakeWorker = false;
+    commandLatencyCount = 0;
+    
+    publishState();
+    
+    strandRequests = 0;
+    bStrandTimer = false;
+    bClosing = false;
+    
     // let's go!
-    startThread(true);
+    bUsePool = bUseWorkerPool;
+    if(bUsePool){
+        ofxThreadedVideoPool::getPool().setupOnce(workerPoolThreads);
+    }else{
+        startThread(true);
+    }
 }
 
 //--------------------------------------------------------------
 ofxThreadedVideo::~ofxThreadedVideo(){
 
-    // stop threading
-    waitForThread(true);
+    if(bUsePool){
+        // stop the strand rescheduling itself then pull it out of the pool
+        bClosing = true;
+        ofxThreadedVideoPool::getPool().remove(this);
+    }else{
+        // stop threading - the worker may be asleep waiting for a command so wake it
+        stopThread();
+        signalWorker();
+        waitForThread(false);
+    }
+    
+    // anyone holding a handle to a command that never ran sees it cancelled
+    ofxThreadedVideoCommands.clear();
+    
+    releaseFrameBuffers();
+    clearPreloadCache();
     
     // close anything left open
+    lockBackend();
     video[0].close();
     video[1].close();
+    unlockBackend();
     
     drawTexture.clear();
+    chromaTextures[0].clear();
+    chromaTextures[1].clear();
 
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::update(){
     
+    if(bUseTexture && !drawTexture.isAllocated()){
+        drawTexture.allocate(1, 1, GL_RGB);
+        ofPixels p;
+        p.allocate(1, 1, OF_IMAGE_COLOR);
+        p.set(0);
+        drawTexture.loadData(p.getPixels(), 1, 1, GL_RGB);
+        texturePixelFormat = OF_PIXELS_UNKNOWN;
+        bTextureConverted = bPlanarTexture = false;
+    }
+    
     lock();
     
     if(!bCriticalSection && bLoaded){
         bCriticalSection = true;
+        criticalSectionThread = this_thread::get_id();
         int videoID = currentVideoID;
-        bool bUpdate = bLoaded;
+        // don't show a frame from a half applied batch
+        bool bUpdate = bLoaded && groupRemaining == 0;
+        // when the worker owns the backend it also owns seeks and black stops
+        bool bWorkerBackend = bBackendOnWorker;
+        bool bForceFrame = bForceFrameNew && !bWorkerBackend;
         unlock();
         
         if(bUpdate){
             
-//            lock();
-            video[videoID].update();
+            ofxThreadedVideoFrame * decodedFrame = NULL;
             
-            bIsFrameNew = video[videoID].isFrameNew();
-            position = video[videoID].getPosition();
-            frameCurrent = video[videoID].getCurrentFrame();
-            bIsMovieDone = video[videoID].getIsMovieDone();
-//            unlock();
+            bool bUseRing = decodeAheadFrames > 0 || outputWidth > 0 || outputHeight > 0;
+            if(bWorkerBackend || (bUseRing && frameBuffers.size() > 0 && !bForceFrame)){
+                // the worker has already run the backend, just take whatever is due
+                if(frameBuffers.size() > 0) decodedFrame = presentDecodedFrame();
+                bIsFrameNew = decodedFrame != NULL;
+                if(bIsFrameNew){
+                    // getPixels() has to match what's shown, not the backend
+                    // the worker is already decoding ahead into
+                    lock();
+                    pixels = decodedFrame->pixels;
+                    unlock();
+                    position = decodedFrame->position;
+                    frameCurrent = decodedFrame->frameCurrent;
+                    bIsMovieDone = decodedFrame->bIsMovieDone;
+                }
+            }else{
+                // seeks and black stops make anything decoded ahead stale
+                if(bForceFrame) clearDecodedFrames();
+                
+//                lock();
+                video[videoID].update();
+                
+                bIsFrameNew = video[videoID].isFrameNew();
+                position = video[videoID].getPosition();
+                frameCurrent = video[videoID].getCurrentFrame();
+                bIsMovieDone = video[videoID].getIsMovieDone();
+//                unlock();
+                
+                // a playlist moves on the moment the current item is done
+                if(bIsMovieDone && switchPlaylistItem(videoID)) bIsFrameNew = true;
+            }
             
-            if(bIsFrameNew || bForceFrameNew){
+            if(bIsFrameNew || bForceFrame){
                 
-                if(bForceFrameNew) lock();
+                if(bForceFrame) lock();
                 
                 if(!bIsTextureReady) bIsTextureReady = true;
                 
-                if(drawTexture.getWidth() != width || drawTexture.getHeight() != height){
+                // frames still in the ring can be from the previous playlist
+                // item, and the backend's own can be smaller than the movie
+                ofPixels * framePixels = decodedFrame != NULL ? decodedFrame->pixels : &video[videoID].getPixelsRef();
+                ofPixelFormat framePixelFormat = decodedFrame != NULL ? decodedFrame->pixels->getPixelFormat() : internalPixelFormat;
+                if(decodedFrame == NULL && framePixels->isAllocated()){
+                    // seeks and the first frames don't come through the ring
+                    int scaledWidth, scaledHeight;
+                    if(ofxThreadedVideoConvert::isScaleSupported(framePixels->getPixelFormat()) &&
+                       ofxThreadedVideoConvert::getScaledSize(framePixels->getWidth(), framePixels->getHeight(), outputWidth, outputHeight, scaledWidth, scaledHeight)){
+                        if(ofxThreadedVideoConvert::scalePixels(*framePixels, uploadPixels, scaledWidth, scaledHeight)){
+                            framePixels = &uploadPixels;
+                        }else{
+                            ofLogError("ofxThreadedVideo") << "Couldn't scale " << framePixels->getWidth() << "x" << framePixels->getHeight() << " to " << scaledWidth << "x" << scaledHeight;
+                        }
+                    }
+                }
+                float frameWidth = framePixels->isAllocated() ? framePixels->getWidth() : width;
+                float frameHeight = framePixels->isAllocated() ? framePixels->getHeight() : height;
+                
+                if(bUseTexture && (drawTexture.getWidth() != frameWidth || drawTexture.getHeight() != frameHeight || texturePixelFormat != framePixelFormat)){
+                    
+                    // frames converted on the worker don't need the shader
+                    texturePixelFormat = framePixelFormat;
+                    bTextureConverted = framePixelFormat != internalPixelFormat;
+                    bPlanarTexture = ofxThreadedVideoConvert::isPlanarPixelFormat(framePixelFormat);
                     
                     ofTextureData texData;
                     
-                    texData.width = width;
-                    texData.height = height;
+                    texData.width = frameWidth;
+                    texData.height = frameHeight;
                     texData.textureTarget = GL_TEXTURE_2D;
   
-                    switch (internalPixelFormat) {
+                    switch (framePixelFormat) {
                         case OF_PIXELS_RGB:
                             textureInternalType = GL_RGB;
                             textureFormatType = GL_RGB;
                             texturePixelType = GL_UNSIGNED_BYTE;
-                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,width,1,3);
+                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,frameWidth,1,3);
                             break;
                         case OF_PIXELS_RGBA:
                             textureInternalType = GL_RGBA;
                             textureFormatType = GL_RGBA;
                             texturePixelType = GL_UNSIGNED_BYTE;
-                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,width,1,4);
+                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,frameWidth,1,4);
                             break;
                         case OF_PIXELS_BGRA:
                             textureInternalType = GL_RGBA;
                             textureFormatType = GL_BGRA;
                             texturePixelType = GL_UNSIGNED_INT_8_8_8_8_REV;
-                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,width,1,4);
+                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,frameWidth,1,4);
                             break;
 #if (OF_VERSION_MAJOR == 0) && (OF_VERSION_MINOR <= 8)
                         case OF_PIXELS_2YUV:
@@ -208,7 +717,7 @@ void ofxThreadedVideo::update(){
                         case OF_PIXELS_YUY2:
 #endif
                             if(bUseInternalShader){
-                                fboYUY2.allocate(width, height);
+                                fboYUY2.allocate(frameWidth, frameHeight);
                                 /*fboYUY2.begin();
                                 ofClear(0, 0, 0, 255);
                                 ofPushStyle();
@@ -224,11 +733,44 @@ void ofxThreadedVideo::update(){
                                 fboYUY2.draw(-1000, -1000, width, height);
                                 shader.end();*/
                             }
+#ifdef TARGET_OSX
                             textureInternalType = GL_RGB;
                             textureFormatType = GL_RGB_422_APPLE;
                             texturePixelType = GL_UNSIGNED_SHORT_8_8_APPLE;
-                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,width,1,4);
+#else
+                            // GL_APPLE_rgb_422 is only a given on OSX: elsewhere upload the
+                            // two bytes per pixel as they are so at least sizes stay right
+                            textureInternalType = GL_LUMINANCE_ALPHA;
+                            textureFormatType = GL_LUMINANCE_ALPHA;
+                            texturePixelType = GL_UNSIGNED_BYTE;
+#endif
+                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,frameWidth,1,4);
                             break;
+#if !((OF_VERSION_MAJOR == 0) && (OF_VERSION_MINOR <= 8))
+                        case OF_PIXELS_I420:
+                        case OF_PIXELS_NV12:
+                        {
+                            // drawTexture is the luma plane, chroma is half size
+                            textureInternalType = GL_LUMINANCE;
+                            textureFormatType = GL_LUMINANCE;
+                            texturePixelType = GL_UNSIGNED_BYTE;
+                            ofSetPixelStoreiAlignment(GL_UNPACK_ALIGNMENT,frameWidth,1,1);
+                            
+                            int chromaType = framePixelFormat == OF_PIXELS_NV12 ? GL_LUMINANCE_ALPHA : GL_LUMINANCE;
+                            ofTextureData chromaData;
+                            chromaData.width = (int)frameWidth / 2;
+                            chromaData.height = (int)frameHeight / 2;
+                            chromaData.textureTarget = GL_TEXTURE_2D;
+                            chromaData.glInternalFormat = chromaType;
+                            chromaTextures[0].allocate(chromaData, chromaType, GL_UNSIGNED_BYTE);
+                            if(framePixelFormat == OF_PIXELS_I420){
+                                chromaTextures[1].allocate(chromaData, chromaType, GL_UNSIGNED_BYTE);
+                            }else{
+                                chromaTextures[1].clear();
+                            }
+                            break;
+                        }
+#endif
                         default:
                             break;
                     }
@@ -250,15 +792,27 @@ void ofxThreadedVideo::update(){
 #endif
                 }
                 
-				if(bForceBlack){
+				if(decodedFrame != NULL){
+					if(decodedFrame->bBlack){
+						lock();
+						bForceBlack = bLoaded = false;
+						unlock();
+					}
+				}else if(bForceBlack){
 					video[videoID].getPixelsRef().set(0);
 					bForceBlack = bLoaded = false;
 				}
 
-                unsigned char * pixels = video[videoID].getPixels();
-                if(pixels != NULL && bUseTexture) drawTexture.loadData(pixels, width, height, textureFormatType, texturePixelType);
+                unsigned char * pixels = framePixels->getPixels();
+                if(pixels != NULL && bUseTexture){
+                    if(bPlanarTexture){
+                        loadPlaneTextures(pixels, frameWidth, frameHeight);
+                    }else{
+                        drawTexture.loadData(pixels, frameWidth, frameHeight, textureFormatType, texturePixelType);
+                    }
+                }
                 
-                if(bForceFrameNew){
+                if(bForceFrame){
                     bForceFrameNew = false;
                     unlock();
                 }
@@ -280,28 +834,71 @@ void ofxThreadedVideo::update(){
         
         lock();
         bCriticalSection = false;
+        criticalSectionCondition.notify_all();
+        publishState();
         unlock();
     }else{
         unlock();
     }
     
+    // the worker executes everything itself
+    if(bBackendOnWorker) return;
+    
     lock();
-    ofxThreadedVideoGlobalMutex.lock();
-    if(!ofxThreadedVideoGlobalCritical && !bCriticalSection){
+    if(!bCriticalSection){
         int videoID = currentVideoID;
-        ofxThreadedVideoGlobalCritical = true;
         bCriticalSection = true;
+        criticalSectionThread = this_thread::get_id();
         ofxThreadedVideoCommand c = getCommand();
         bool bCanStop = (bLoaded && !bIsLoading) || (!bLoaded && !bIsLoading);
         bool bPopCommand = false;
+        bool bSignalWorker = false;
+        unsigned long long timeStarted = ofGetElapsedTimeMicros();
         unlock();
-        ofxThreadedVideoGlobalMutex.unlock();
 
-        if(c.getInstance() == instanceID){
-            
-            if(c.getCommand() == "stop" && bCanStop){
+        bPopCommand = executeUpdateCommand(c, videoID, bCanStop, bSignalWorker, timeStarted);
+        
+        lock();
+        
+        if(bPopCommand){
+            popCommand(timeStarted);
+        }else{
+            releaseCommand();
+        }
+        if(bFlushPending){
+            ofxThreadedVideoCommands.clear();
+            groupRemaining = 0;
+            bFlushPending = false;
+        }
+        
+        bCriticalSection = false;
+        criticalSectionCondition.notify_all();
+        publishState();
+        unlock();
+        
+        // the worker may be waiting on whatever is at the head now
+        if(bPopCommand || bSignalWorker) signalWorker();
+    }else{
+        unlock();
+    }
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::executeUpdateCommand(const ofxThreadedVideoCommand& c, int videoID, bool bCanStop, bool& bSignalWorker, unsigned long long timeStarted){
+    
+    // the commands update() executes itself, or the worker when the
+    // backend is worker only; returns whether the command should be popped
+    bool bPopCommand = false;
+    
+    if(c.getInstance() == instanceID){
+        
+        switch(c.getCommand()){
+            case VIDEO_COMMAND_STOP:
+            {
+                if(!bCanStop) break;
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                 if(bIsPlaying) video[videoID].stop();
+                clearDecodedFrames();
                 lock();
                 //fade = 1.0;
                 fades.clear();
@@ -311,18 +908,32 @@ void ofxThreadedVideo::update(){
                 bIsFrameNew = false;
                 bIsMovieDone = false;
                 bLoaded = false;
-				if(bUseBlackStop) bForceBlack = bForceFrameNew = bIsFrameNew = bLoaded = true;
+                endPlaylist();
+                if(bUseBlackStop) bForceBlack = bForceFrameNew = bIsFrameNew = bLoaded = true;
                 unlock();
                 bPopCommand = true;
+                break;
             }
-            
-            if(c.getCommand() == "loadMovie" && bCanStop){
+            case VIDEO_COMMAND_LOAD:
+            {
+                if(!bCanStop) break;
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString() << " execute in update";
+                handles->start(c.handleSlot, timeStarted);
+                clearDecodedFrames();
                 if(bIsPlaying){
+                    lockBackend();
                     video[videoID].stop();
                     video[videoID].close();
+                    unlockBackend();
                 }
                 lock();
+                // the playlist's own first load keeps it, any other ends it
+                if(bPlaylistStarting){
+                    bPlaylistStarting = false;
+                    prerollID = -1;
+                }else{
+                    endPlaylist();
+                }
                 currentVideoID = getNextLoadID();
                 bIsPaused = false;
                 bLoaded = false;
@@ -330,9 +941,11 @@ void ofxThreadedVideo::update(){
                 bIsPlaying = false;
                 bIsMovieDone = false;
                 unlock();
+                bSignalWorker = true;
+                break;
             }
-            
-            if(c.getCommand() == "play"){
+            case VIDEO_COMMAND_PLAY:
+            {
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                 video[videoID].play();
                 
@@ -342,30 +955,33 @@ void ofxThreadedVideo::update(){
                 unlock();
                 
                 bPopCommand = true;
+                break;
             }
-            
-            if(c.getCommand() == "setSpeed"){
+            case VIDEO_COMMAND_SET_SPEED:
+            {
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                 lock();
-                speed = c.getArgument<float>(0);
+                speed = c.args.value;
                 unlock();
                 video[videoID].setSpeed(speed);
                 bPopCommand = true;
+                break;
             }
-            
-            if(c.getCommand() == "setPaused"){
+            case VIDEO_COMMAND_SET_PAUSED:
+            {
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                 lock();
-                bIsPaused = c.getArgument<bool>(0);
+                bIsPaused = c.args.paused;
                 unlock();
                 video[videoID].setPaused(bIsPaused);
                 bPopCommand = true;
+                break;
             }
-            
-            if(c.getCommand() == "setFrame"){
+            case VIDEO_COMMAND_SET_FRAME:
+            {
                 if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                 lock();
-                int frameTarget = c.getArgument<int>(0);
+                int frameTarget = c.args.frame;
                 bForceFrameNew = true;
                 frameTarget = CLAMP(frameTarget, 0, frameTotal);
                 //cout << "setframe A: " << frameTarget << " " << videoID << " " << bCriticalSection << endl;
@@ -373,110 +989,138 @@ void ofxThreadedVideo::update(){
                 //cout << "setframe B: " << frameTarget << " " << videoID << " " << bCriticalSection << endl;
                 unlock();
                 bPopCommand = true;
+                break;
             }
-            
+            default:
+                break;
         }
         
-        lock();
-        ofxThreadedVideoGlobalMutex.lock();
-        
-        if(bPopCommand) popCommand();
-        
-        ofxThreadedVideoGlobalCritical = false;
-        bCriticalSection = false;
-        ofxThreadedVideoGlobalMutex.unlock();
-        unlock();
-    }else{
-        ofxThreadedVideoGlobalMutex.unlock();
-        unlock();
     }
+    
+    return bPopCommand;
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::threadedFunction(){
 
     while (isThreadRunning()){
+        
+        bool bContended = false;
+        int tickMillis = 0;
+        
+        // go straight round again if we did something, there may be more
+        if(!threadedUpdate(bContended, tickMillis)) waitForWork(bContended, tickMillis);
 
-        lock();
-        ofxThreadedVideoGlobalMutex.lock();
-        if(!ofxThreadedVideoGlobalCritical && !bCriticalSection){
-            ofxThreadedVideoGlobalCritical = true;
-            bCriticalSection = true;
-            int videoID = currentVideoID;
-            ofxThreadedVideoCommand c = getCommand();
-            bool bCanLoad = !bLoaded;
-            bool bPopCommand = false;
+    }
+        
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::threadedUpdate(bool& bContended, int& tickMillis){
+
+    bool bPopCommand = false;
+    bool bCommandFailed = false;
+    
+    lock();
+    if(!bCriticalSection){
+        bCriticalSection = true;
+        criticalSectionThread = this_thread::get_id();
+        int videoID = currentVideoID;
+        ofxThreadedVideoCommand c = getCommand();
+        bool bCanLoad = !bLoaded;
+        bool bCanStop = !bIsLoading;
+        bool bWorkerBackend = bBackendOnWorker;
+        unsigned long long timeStarted = ofGetElapsedTimeMicros();
+        unlock();
+        
+        if(bWorkerBackend && c.getInstance() == instanceID){
+            // do update()'s share of the commands here too; a load is only
+            // prepared by that, so pick up the new player and carry on
+            bool bSignalWorker = false;
+            bPopCommand = executeUpdateCommand(c, videoID, bCanStop, bSignalWorker, timeStarted);
+            lock();
+            videoID = currentVideoID;
+            bCanLoad = !bLoaded;
             unlock();
-            ofxThreadedVideoGlobalMutex.unlock();
+        }
+        
+        if(c.getInstance() == instanceID){
             
-            if(c.getInstance() == instanceID){
-                
-                if(c.getCommand() == "setPosition"){
+            switch(c.getCommand()){
+                case VIDEO_COMMAND_SET_POSITION:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     lock();
-                    position = c.getArgument<float>(0);
+                    position = c.args.value;
                     unlock();
                     video[videoID].setPosition(position);
                     bPopCommand = true;
+                    break;
                 }
-
-                if(c.getCommand() == "setVolume"){
+                case VIDEO_COMMAND_SET_VOLUME:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     lock();
-                    volume = c.getArgument<float>(0);
+                    volume = c.args.value;
                     unlock();
                     video[videoID].setVolume(volume);
                     bPopCommand = true;
+                    break;
                 }
-                
 #ifdef USE_QUICKTIME_7
-                if(c.getCommand() == "setPan"){
+                case VIDEO_COMMAND_SET_PAN:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     lock();
-                    pan = c.getArgument<float>(0);
+                    pan = c.args.value;
                     unlock();
                     video[videoID].setPan(pan);
                     bPopCommand = true;
+                    break;
                 }
 #endif
-                
-                if(c.getCommand() == "setLoopState"){
+                case VIDEO_COMMAND_SET_LOOP_STATE:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     lock();
-                    loopState = (ofLoopType)c.getArgument<int>(0);
+                    loopState = (ofLoopType)c.args.loopState;
                     unlock();
                     video[videoID].setLoopState(loopState);
                     bPopCommand = true;
+                    break;
                 }
-                
-                if(c.getCommand() == "setAnchorPercent"){
+                case VIDEO_COMMAND_SET_ANCHOR_PERCENT:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
-                    video[videoID].setAnchorPercent(c.getArgument<float>(0), c.getArgument<float>(0));
+                    video[videoID].setAnchorPercent(c.args.anchor.x, c.args.anchor.y);
                     bPopCommand = true;
+                    break;
                 }
-
-                if(c.getCommand() == "setAnchorPoint"){
+                case VIDEO_COMMAND_SET_ANCHOR_POINT:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
-                    video[videoID].setAnchorPercent(c.getArgument<float>(0), c.getArgument<float>(0));
+                    video[videoID].setAnchorPoint(c.args.anchor.x, c.args.anchor.y);
                     bPopCommand = true;
+                    break;
                 }
-                
-                if(c.getCommand() == "resetAnchor"){
+                case VIDEO_COMMAND_RESET_ANCHOR:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     video[videoID].resetAnchor();
                     bPopCommand = true;
+                    break;
                 }
-                
-                if(c.getCommand() == "setFade"){
+                case VIDEO_COMMAND_SET_FADE:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     
                     int frameEnd;
-                    int frameStart = c.getArgument<int>(0);
-                    int durationMillis = c.getArgument<int>(1);
-                    float fadeTarget = c.getArgument<float>(2);
-                    bool fadeSound = c.getArgument<bool>(3);
-                    bool fadeVideo = c.getArgument<bool>(4);
-                    bool fadeOnce = c.getArgument<bool>(5);
+                    int frameStart = c.args.fade.frameStart;
+                    int durationMillis = c.args.fade.durationMillis;
+                    float fadeTarget = c.args.fade.fadeTarget;
+                    bool fadeSound = c.args.fade.fadeSound;
+                    bool fadeVideo = c.args.fade.fadeVideo;
+                    bool fadeOnce = c.args.fade.fadeOnce;
                     
                     CLAMP(fadeTarget, 0.0f, 1.0f);
                     
@@ -513,33 +1157,78 @@ void ofxThreadedVideo::threadedFunction(){
                         unlock();
                     }
                     
-
-                    
                     bPopCommand = true;
+                    break;
+                }
+                case VIDEO_COMMAND_SET_PLAYLIST:
+                {
+                    if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
+                    lock();
+                    map<int, PendingPlaylist>::iterator it = pendingPlaylists.find(c.args.frame);
+                    if(it != pendingPlaylists.end()){
+                        playlist = it->second.paths;
+                        bPlaylistLoop = it->second.bLoop;
+                        playlistIndex = 0;
+                        prerollID = -1;
+                        playlistGeneration++;
+                        bPlaylistStarting = true;
+                        // anything older was flushed or superseded
+                        pendingPlaylists.erase(pendingPlaylists.begin(), ++it);
+                    }
+                    unlock();
+                    bPopCommand = true;
+                    break;
+                }
+                case VIDEO_COMMAND_PRELOAD:
+                {
+                    if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
+                    preloadPlayer(c.getPath());
+                    bPopCommand = true;
+                    break;
                 }
-                
 #ifdef USE_JACK_AUDIO
-                if(c.getCommand() == "setAudioTrackToChannel"){
+                case VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
-                    video[videoID].setAudioTrackToChannel(c.getArgument<int>(0), c.getArgument<int>(1), c.getArgument<int>(2));
+                    video[videoID].setAudioTrackToChannel(c.args.audioTrack.trackIndex, c.args.audioTrack.oldChannelLabel, c.args.audioTrack.newChannelLabel);
                     bPopCommand = true;
+                    break;
                 }
-                
-                if(c.getCommand() == "setAudioDevice"){
+                case VIDEO_COMMAND_SET_AUDIO_DEVICE:
+                {
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
-                    video[videoID].setAudioDevice(c.getArgument<string>(0));
+                    video[videoID].setAudioDevice(c.getPath());
                     bPopCommand = true;
+                    break;
                 }
 #endif
-                
-                if(c.getCommand() == "loadMovie" && bCanLoad){
+                case VIDEO_COMMAND_LOAD:
+                {
+                    if(!bCanLoad) break;
                     
                     if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString();
                     
-                    if(video[videoID].loadMovie(c.getArgument<string>(0))){
+                    bool bLoadOk = false;
+                    ofPtr<ofBaseVideoPlayer> preloaded;
+                    if(takePreloadedPlayer(c.getPath(), preloaded)){
+                        // already open and prerolled, just swap it in
+                        ofPtr<ofBaseVideoPlayer> previous = video[videoID].getPlayer();
+                        video[videoID].setPlayer(preloaded);
+                        lockBackend();
+                        previous.reset();
+                        unlockBackend();
+                        bLoadOk = true;
+                    }else{
+                        lockBackend();
+                        setPlayerOutputSize(video[videoID].getPlayer(), outputWidth, outputHeight);
+                        bLoadOk = video[videoID].loadMovie(c.getPath());
+                        unlockBackend();
+                    }
+                    
+                    if(bLoadOk){
                         
                         if(bVerbose) ofLogVerbose() << instanceID << " = " << c.getCommandAsString() << " executed in thread";;
-
+                        
                         lock();
                         
                         fades.clear();
@@ -554,13 +1243,19 @@ void ofxThreadedVideo::threadedFunction(){
                         volume = video[videoID].getVolume(); // we should implement for QT6
                         pan = video[videoID].getPan();
 #endif
+                        // a first load never goes through update(), which is
+                        // where the playlist's first item is otherwise let go
+                        bPlaylistStarting = false;
+                        
+                        // playlist items have to finish for the next to start
+                        if(playlist.size() > 0) video[videoID].setLoopState(OF_LOOP_NONE);
                         loopState = video[videoID].getLoopState();
                         
-                        moviePath = c.getArgument<string>(0);
-#ifdef TARGET_OSX
-                        vector<string> pathParts = ofSplitString(moviePath, "/");
-#else
+                        moviePath = c.getPath();
+#ifdef TARGET_WIN32
                         vector<string> pathParts = ofSplitString(moviePath, "\\");
+#else
+                        vector<string> pathParts = ofSplitString(moviePath, "/");
 #endif
                         movieName = pathParts[pathParts.size() - 1];
                         
@@ -572,12 +1267,14 @@ void ofxThreadedVideo::threadedFunction(){
                         bLoaded = true;
                         
                         pixels = &video[videoID].getPixelsRef();
-
+                        
+                        // listeners will want the new state straight away
+                        publishState();
                         unlock();
                         
                         bPopCommand = true;
                         
-                        ofxThreadedVideoEvent e = ofxThreadedVideoEvent(c.getArgument<string>(0), VIDEO_EVENT_LOAD_OK, this);
+                        ofxThreadedVideoEvent e = ofxThreadedVideoEvent(c.getPath(), VIDEO_EVENT_LOAD_OK, this);
                         ofNotifyEvent(threadedVideoEvent, e, this);
                         
                         ofxThreadedVideoLoadOk++;
@@ -586,118 +1283,603 @@ void ofxThreadedVideo::threadedFunction(){
                         
                         ofLogError() << "Could not load: " << instanceID << " + " << c.getCommandAsString();
                         
+                        lockBackend();
                         video[videoID].close();
+                        unlockBackend();
                         
-                        ofxThreadedVideoEvent e = ofxThreadedVideoEvent(c.getArgument<string>(0), VIDEO_EVENT_LOAD_FAIL, this);
+                        // nothing is loading any more, so stop() etc. can run again
+                        lock();
+                        bIsLoading = false;
+                        bLoaded = false;
+                        publishState();
+                        unlock();
+                        
+                        // pop the failed load so it doesn't block the queue
+                        bPopCommand = true;
+                        bCommandFailed = true;
+                        
+                        ofxThreadedVideoEvent e = ofxThreadedVideoEvent(c.getPath(), VIDEO_EVENT_LOAD_FAIL, this);
                         ofNotifyEvent(threadedVideoEvent, e, this);
                         
                         ofxThreadedVideoLoadFail++;
                     }
-                    
+                    break;
                 }
-                
+                default:
+                    break;
             }
             
-            if(bPopCommand) video[videoID].update();
+        }
         
+        int numDecodeAhead = decodeAheadFrames;
+        bool bUseRing = numDecodeAhead > 0 || bWorkerBackend || outputWidth > 0 || outputHeight > 0;
+        if(bWorkerBackend){
+            // a stop may have unloaded (or black stop reloaded) since we looked
             lock();
-            
-            if(bIsFrameNew){
-                for(int i = 0; i < fades.size(); i++){
-                    
-                    ofxThreadedVideoFade& currentFade = fades.at(i);
-                    
-                    if(currentFade.getIsFading(frameCurrent)){
-                        _fade = currentFade.getFade(_fade, frameCurrent);
-                        
-                        if(currentFade.fadeVideo){
-                            if(fade != _fade) fade = _fade;
-                        }
-#ifdef USE_QUICKTIME_7
-                        if(currentFade.fadeSound){ // we should implement for QT6
-                            if(video[videoID].getVolume() != _fade) video[videoID].setVolume(_fade);
-                        }
-#endif
-                    }
+            bCanLoad = !bLoaded;
+            unlock();
+        }
+        if(bUseRing && !bCanLoad && c.getCommand() != VIDEO_COMMAND_LOAD){
+            decodeAhead(videoID, bWorkerBackend);
+            // the ring carries on straight into the next playlist item
+            if(video[videoID].getIsMovieDone() && switchPlaylistItem(videoID)) decodeAhead(videoID, false, true);
+        }else{
+            if(!bUseRing && frameBuffers.size() > 0) releaseFrameBuffers();
+            if(bPopCommand) video[videoID].update();
+        }
+    
+        lock();
+        
+        if(bIsFrameNew){
+            for(int i = 0; i < fades.size(); i++){
+                
+                ofxThreadedVideoFade& currentFade = fades.at(i);
+                
+                if(currentFade.getIsFading(frameCurrent)){
+                    _fade = currentFade.getFade(_fade, frameCurrent);
                     
-                    if(currentFade.fadeOnce && currentFade.getFadeDone(frameCurrent)){
-                        fades.erase(fades.begin() + i);
-                        i--;
+                    if(currentFade.fadeVideo){
+                        if(fade != _fade) fade = _fade;
                     }
-
+#ifdef USE_QUICKTIME_7
+                    if(currentFade.fadeSound){ // we should implement for QT6
+                        if(video[videoID].getVolume() != _fade) video[videoID].setVolume(_fade);
+                    }
+#endif
+                }
+                
+                if(currentFade.fadeOnce && currentFade.getFadeDone(frameCurrent)){
+                    fades.erase(fades.begin() + i);
+                    i--;
                 }
+
             }
+        }
 
-            ofxThreadedVideoGlobalMutex.lock();
-            
-            if(bPopCommand) popCommand();
-            
-            ofxThreadedVideoGlobalCritical = false;
-            bCriticalSection = false;
-            ofxThreadedVideoGlobalMutex.unlock();
-            unlock();
+        if(bPopCommand){
+            popCommand(timeStarted, bCommandFailed);
         }else{
-            ofxThreadedVideoGlobalMutex.unlock();
-            unlock();
+            releaseCommand();
+        }
+        if(bFlushPending){
+            ofxThreadedVideoCommands.clear();
+            groupRemaining = 0;
+            bFlushPending = false;
         }
         
-        ofSleepMillis(1000.0/30.0);
+        tickMillis = fades.size() > 0 ? 1000 / 30 : 0;
+        if(bUseRing && bLoaded && bIsPlaying && !bIsPaused){
+            // poll the backend at twice the movie's frame rate
+            int decodeMillis = MAX(1, (int)(getFrameDurationMillis() / 2));
+            tickMillis = tickMillis == 0 ? decodeMillis : MIN(tickMillis, decodeMillis);
+        }
+        bCriticalSection = false;
+        criticalSectionCondition.notify_all();
+        publishState();
+        unlock();
+    }else{
+        bContended = true;
+        unlock();
+    }
+    
+    if(!bPopCommand && !bContended) prerollPlaylistItem();
+    
+    return bPopCommand;
+}
 
+//--------------------------------------------------------------
+void ofxThreadedVideo::runTask(){
+    
+    int requests = strandRequests;
+    
+    bool bPopCommand = false;
+    bool bContended = false;
+    int tickMillis = 0;
+    
+    // bounded number of passes so one busy instance can't hog a pool thread
+    for(int i = 0; i < 16 && !bClosing; i++){
+        bContended = false;
+        tickMillis = 0;
+        bPopCommand = threadedUpdate(bContended, tickMillis);
+        if(!bPopCommand) break;
     }
-        
+    
+    if(bClosing) return;
+    
+    if(strandRequests.fetch_sub(requests) != requests){
+        // woken while we were running - we're still scheduled so go again
+        ofxThreadedVideoPool::getPool().submit(this);
+    }else if(bPopCommand){
+        scheduleStrand();
+    }else if((bContended || tickMillis > 0) && !bStrandTimer.exchange(true)){
+        // same ticks as waitForWork() but via a pool timer
+        ofxThreadedVideoPool::getPool().submitAfter(this, bContended ? 1 : tickMillis);
+    }
+    
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::pushCommand(ofxThreadedVideoCommand& c, bool back){
-    lock();
-    ofxThreadedVideoGlobalMutex.lock();
+void ofxThreadedVideo::wakeTask(){
+    // only pool timers call this
+    bStrandTimer = false;
+    scheduleStrand();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::scheduleStrand(){
+    if(bClosing) return;
+    // only the first request submits, the strand picks up the rest when it finishes
+    if(strandRequests.fetch_add(1) == 0) ofxThreadedVideoPool::getPool().submit(this);
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoHandle ofxThreadedVideo::pushCommand(ofxThreadedVideoCommand& c){
     if(bVerbose) ofLogVerbose() << instanceID << " + push " << c.getCommandAsString();
-    if(back){
-        ofxThreadedVideoCommands.push_back(c);
-    }else{
-        ofxThreadedVideoCommands.push_front(c);
+    c.timeQueued = ofGetElapsedTimeMicros();
+    unsigned int generation;
+    c.handleSlot = handles->allocate(generation, c.timeQueued);
+    ofxThreadedVideoHandle handle(handles, c.handleSlot, generation);
+    // the command already pending will pick up the new value, nothing to signal
+    if(ofxThreadedVideoCommands.coalesce(c)) return handle;
+    if(!ofxThreadedVideoCommands.push(c)){
+        // a batch reports its own overflow in endBatch()
+        if(!ofxThreadedVideoCommands.isBatching()) ofLogError() << instanceID << " command queue full (" << OFX_THREADED_VIDEO_QUEUE_SIZE << ") dropping " << c.getCommandAsString();
+        handles->finish(c.handleSlot, VIDEO_HANDLE_FAILED, c.timeQueued, c.timeQueued);
+        return handle;
     }
-    ofxThreadedVideoGlobalMutex.unlock();
-    unlock();
+    if(!ofxThreadedVideoCommands.isBatching()) signalWorker();
+    return handle;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoHandle ofxThreadedVideo::failCommand(ofxThreadedVideoCommand& c){
+    // for commands that can't be queued at all: the handle reads as failed straight away
+    c.timeQueued = ofGetElapsedTimeMicros();
+    unsigned int generation;
+    c.handleSlot = handles->allocate(generation, c.timeQueued);
+    handles->finish(c.handleSlot, VIDEO_HANDLE_FAILED, c.timeQueued, c.timeQueued);
+    return ofxThreadedVideoHandle(handles, c.handleSlot, generation);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::signalWorker(){
+    if(bUsePool){
+        scheduleStrand();
+        return;
+    }
+    {
+        ofScopedLock wakeLock(wakeMutex);
+        bWakeWorker = true;
+    }
+    wakeCondition.notify_one();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::waitForWork(bool bContended, int tickMillis){
+    ofScopedLock wakeLock(wakeMutex);
+    if(!bWakeWorker){
+        if(bContended){
+            // update() holds the critical section - it won't necessarily signal us
+            wakeCondition.wait_for(wakeLock, chrono::milliseconds(1));
+        }else if(tickMillis > 0){
+            // fades are evaluated per frame and decode ahead pumps the backend,
+            // so keep ticking while either is active
+            wakeCondition.wait_for(wakeLock, chrono::milliseconds(tickMillis));
+        }else{
+            wakeCondition.wait(wakeLock, [this]{ return bWakeWorker; });
+        }
+    }
+    bWakeWorker = false;
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::popCommand(){
-    ofxThreadedVideoCommand& c = ofxThreadedVideoCommands.front();
+void ofxThreadedVideo::popCommand(unsigned long long timeStarted, bool bFailed){
+    if(!bCommandClaimed) return;
+    bCommandClaimed = false;
+    const ofxThreadedVideoCommand& c = ofxThreadedVideoCommands.front();
     if(bVerbose) ofLogVerbose() << instanceID << " - pop " << c.getCommandAsString();
-    ofxThreadedVideoCommands.pop_front();
+    commandLatency[commandLatencyCount % OFX_THREADED_VIDEO_LATENCY_SAMPLES] = (float)(timeStarted - MIN(timeStarted, c.timeQueued));
+    commandLatencyCount++;
+    groupRemaining = MAX(0, c.groupSize - 1);
+    handles->finish(c.handleSlot, bFailed ? VIDEO_HANDLE_FAILED : VIDEO_HANDLE_DONE, timeStarted, ofGetElapsedTimeMicros());
+    ofxThreadedVideoCommands.pop();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::releaseCommand(){
+    // not ours to execute (or not yet) so let the producer coalesce into it again
+    if(!bCommandClaimed) return;
+    bCommandClaimed = false;
+    ofxThreadedVideoCommands.unclaimFront();
 }
 
 //--------------------------------------------------------------
 ofxThreadedVideoCommand ofxThreadedVideo::getCommand(){
-    if(ofxThreadedVideoCommands.size() > 0){
-        return ofxThreadedVideoCommands.front();
-    }else{
-        return ofxThreadedVideoNullCommand;
+    // only called by whoever holds the critical section, which then has to
+    // popCommand() or releaseCommand() before giving it up
+    ofxThreadedVideoCommand c;
+    bCommandClaimed = ofxThreadedVideoCommands.claimFront(c);
+    return bCommandClaimed ? c : ofxThreadedVideoNullCommand;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoHandle ofxThreadedVideo::load(const string& path){
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_LOAD, instanceID);
+    if(!c.setPath(path)) return failCommand(c);
+    return pushCommand(c);
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoHandle ofxThreadedVideo::loadMovie(const string& path){
+    return load(path);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::setPreloadCache(int numPlayers, size_t maxBytes){
+    list<PreloadedPlayer> evicted;
+    lock();
+    preloadCacheSlots = MAX(0, numPlayers);
+    preloadCacheBytes = maxBytes;
+    trimPreloadCache(evicted);
+    unlock();
+    releasePreloadedPlayers(evicted);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getPreloadCacheSize(){
+    ofScopedLock lock(mutex);
+    return preloadCache.size();
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoHandle ofxThreadedVideo::preload(const string& path){
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_PRELOAD, instanceID);
+    if(!c.setPath(path)) return failCommand(c);
+    return pushCommand(c);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::isPreloaded(const string& path){
+    ofScopedLock lock(mutex);
+    for(list<PreloadedPlayer>::iterator it = preloadCache.begin(); it != preloadCache.end(); ++it){
+        if(it->path == path) return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getPreloadHits(){
+    return preloadHits;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getPreloadMisses(){
+    return preloadMisses;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::preloadPlayer(const string& path){
+    
+    lock();
+    bool bCached = false;
+    for(list<PreloadedPlayer>::iterator it = preloadCache.begin(); it != preloadCache.end(); ++it){
+        if(it->path == path && it->pixelFormat == internalPixelFormat &&
+           it->outputWidth == outputWidth && it->outputHeight == outputHeight){
+            // already open, just make it the most recent
+            preloadCache.splice(preloadCache.begin(), preloadCache, it);
+            bCached = true;
+            break;
+        }
     }
+    bool bEnabled = preloadCacheSlots > 0;
+    PreloadedPlayer entry;
+    entry.path = path;
+    entry.pixelFormat = internalPixelFormat;
+    entry.outputWidth = outputWidth;
+    entry.outputHeight = outputHeight;
+    entry.numBytes = 0;
+    unlock();
+    
+    if(!bEnabled || bCached) return;
+    
+    entry.player = playerFactory();
+    entry.player->setPixelFormat(entry.pixelFormat);
+    
+    lockBackend();
+    setPlayerOutputSize(entry.player, entry.outputWidth, entry.outputHeight);
+    bool bLoadOk = entry.player->load(path);
+    unlockBackend();
+    
+    if(!bLoadOk){
+        ofLogError() << "Could not preload: " << instanceID << " + " << path;
+        lockBackend();
+        entry.player.reset();
+        unlockBackend();
+        return;
+    }
+    
+    entry.numBytes = entry.player->getPixels().getTotalBytes();
+    
+    list<PreloadedPlayer> evicted;
+    lock();
+    preloadCache.push_front(entry);
+    trimPreloadCache(evicted);
+    unlock();
+    releasePreloadedPlayers(evicted);
+    
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideo::takePreloadedPlayer(const string& path, ofPtr<ofBaseVideoPlayer>& player){
+    
+    list<PreloadedPlayer> evicted;
+    bool bFound = false;
+    
+    lock();
+    bool bEnabled = preloadCacheSlots > 0;
+    for(list<PreloadedPlayer>::iterator it = preloadCache.begin(); it != preloadCache.end();){
+        if(it->pixelFormat != internalPixelFormat || it->outputWidth != outputWidth || it->outputHeight != outputHeight){
+            // opened before a setPixelFormat() or setOutputSize(), no use to anyone now
+            evicted.splice(evicted.end(), preloadCache, it++);
+        }else if(!bFound && it->path == path){
+            player = it->player;
+            it = preloadCache.erase(it);
+            bFound = true;
+        }else{
+            ++it;
+        }
+    }
+    unlock();
+    
+    releasePreloadedPlayers(evicted);
+    
+    if(bEnabled){
+        if(bFound){
+            preloadHits++;
+        }else{
+            preloadMisses++;
+        }
+    }
+    
+    return bFound;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::trimPreloadCache(list<PreloadedPlayer>& evicted){
+    // callers hold the mutex
+    size_t numBytes = 0;
+    for(list<PreloadedPlayer>::iterator it = preloadCache.begin(); it != preloadCache.end(); ++it) numBytes += it->numBytes;
+    while(preloadCache.size() > 0 && (preloadCache.size() > preloadCacheSlots || (preloadCacheBytes > 0 && numBytes > preloadCacheBytes))){
+        numBytes -= preloadCache.back().numBytes;
+        evicted.splice(evicted.end(), preloadCache, --preloadCache.end());
+    }
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::releasePreloadedPlayers(list<PreloadedPlayer>& evicted){
+    if(evicted.size() == 0) return;
+    lockBackend();
+    evicted.clear();
+    unlockBackend();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::clearPreloadCache(){
+    list<PreloadedPlayer> evicted;
+    lock();
+    evicted.swap(preloadCache);
+    unlock();
+    releasePreloadedPlayers(evicted);
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::load(const string& path){
-    ofxThreadedVideoCommand c("loadMovie", instanceID);
-    c.setArgument(path);
+void ofxThreadedVideo::setPlaylist(const vector<string>& paths, bool bLoop){
+    
+    if(paths.size() == 0){
+        clearPlaylist();
+        return;
+    }
+    
+    // the list itself can't ride in a command, so park it until the
+    // command runs - that keeps it in order with everything else
+    lock();
+    int playlistID = nextPlaylistID++;
+    PendingPlaylist& pending = pendingPlaylists[playlistID];
+    pending.paths = paths;
+    pending.bLoop = bLoop;
+    unlock();
+    
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_PLAYLIST, instanceID);
+    c.args.frame = playlistID;
     pushCommand(c);
+    load(paths[0]);
+    play();
+    
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::clearPlaylist(){
+    lock();
+    pendingPlaylists.clear();
+    endPlaylist();
+    unlock();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getPlaylistIndex(){
+    ofScopedLock lock(mutex);
+    return playlist.size() > 0 ? playlistIndex : -1;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideo::getPlaylistSize(){
+    ofScopedLock lock(mutex);
+    return playlist.size();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::endPlaylist(){
+    // callers hold the mutex; whatever is prerolled gets loaded over later
+    playlist.clear();
+    playlistIndex = 0;
+    prerollID = -1;
+    playlistGeneration++;
+    bPlaylistStarting = false;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::prerollPlaylistItem(){
+    
+    lock();
+    
+    int nextIndex = playlistIndex + 1;
+    if(nextIndex >= playlist.size() && bPlaylistLoop) nextIndex = 0;
+    
+    if(playlist.size() == 0 || nextIndex >= playlist.size() || prerollID != -1 || bPlaylistStarting ||
+       !bLoaded || bIsLoading || ofxThreadedVideoCommands.size() > 0){
+        unlock();
+        return;
+    }
+    
+    int slot = getNextLoadID();
+    int generation = playlistGeneration;
+    string path = playlist[nextIndex];
+    unlock();
+    
+    // this is done outside the critical section so update() keeps showing
+    // the current item while the next opens; nothing else touches the idle slot
+    bool bLoadOk = false;
+    ofPtr<ofBaseVideoPlayer> preloaded;
+    if(takePreloadedPlayer(path, preloaded)){
+        ofPtr<ofBaseVideoPlayer> previous = video[slot].getPlayer();
+        video[slot].setPlayer(preloaded);
+        lockBackend();
+        previous.reset();
+        unlockBackend();
+        bLoadOk = true;
+    }else{
+        lockBackend();
+        setPlayerOutputSize(video[slot].getPlayer(), outputWidth, outputHeight);
+        bLoadOk = video[slot].loadMovie(path);
+        unlockBackend();
+    }
+    
+    if(bLoadOk){
+        video[slot].setLoopState(OF_LOOP_NONE);
+    }else{
+        ofLogError() << "Could not preroll: " << instanceID << " + " << path;
+        ofxThreadedVideoEvent e = ofxThreadedVideoEvent(path, VIDEO_EVENT_LOAD_FAIL, this);
+        ofNotifyEvent(threadedVideoEvent, e, this);
+        ofxThreadedVideoLoadFail++;
+    }
+    
+    lock();
+    // a load, stop or new playlist while we were busy wins
+    if(generation == playlistGeneration && slot != currentVideoID){
+        if(bLoadOk){
+            prerollID = slot;
+            prerollIndex = nextIndex;
+        }else{
+            // skip it from now on
+            playlist.erase(playlist.begin() + nextIndex);
+            if(nextIndex < playlistIndex) playlistIndex--;
+            if(playlist.size() <= 1 && !bPlaylistLoop) endPlaylist();
+        }
+    }
+    unlock();
+    
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::loadMovie(const string& path){
-    load(path);
+bool ofxThreadedVideo::switchPlaylistItem(int& videoID){
+    
+    // called by whoever holds the critical section and is driving the backend
+    lock();
+    int nextID = prerollID;
+    float nextVolume = volume;
+    unlock();
+    
+    if(nextID == -1 || nextID == videoID) return false;
+    
+    video[nextID].setVolume(nextVolume);
+    video[nextID].play();
+    video[videoID].stop();
+    
+    lock();
+    
+    currentVideoID = nextID;
+    playlistIndex = prerollIndex;
+    prerollID = -1;
+    
+    fades.clear();
+    width = video[nextID].getWidth();
+    height = video[nextID].getHeight();
+    speed = video[nextID].getSpeed();
+    duration = video[nextID].getDuration();
+    position = video[nextID].getPosition();
+    frameCurrent = video[nextID].getCurrentFrame();
+    frameTotal = video[nextID].getTotalNumFrames();
+    loopState = video[nextID].getLoopState();
+    
+    moviePath = playlist[playlistIndex];
+#ifdef TARGET_WIN32
+    vector<string> pathParts = ofSplitString(moviePath, "\\");
+#else
+    vector<string> pathParts = ofSplitString(moviePath, "/");
+#endif
+    movieName = pathParts[pathParts.size() - 1];
+    
+    bIsPaused = false;
+    bIsPlaying = true;
+    bIsMovieDone = false;
+    
+    // with decode ahead the new item's frames show when update() presents them
+    if(presentedFrame.pixels == NULL || pixels != presentedFrame.pixels) pixels = &video[nextID].getPixelsRef();
+    
+    string path = moviePath;
+    publishState();
+    unlock();
+    
+    videoID = nextID;
+    
+    // the worker can start on the item after this one
+    signalWorker();
+    
+    ofxThreadedVideoEvent e = ofxThreadedVideoEvent(path, VIDEO_EVENT_PLAYLIST_NEXT, this);
+    ofNotifyEvent(threadedVideoEvent, e, this);
+    
+    return true;
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::play(){
-    ofxThreadedVideoCommand c("play", instanceID);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_PLAY, instanceID);
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::stop(){
-    ofxThreadedVideoCommand c("stop", instanceID);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_STOP, instanceID);
     pushCommand(c);
 }
 
@@ -714,14 +1896,41 @@ void ofxThreadedVideo::close(){
 //--------------------------------------------------------------
 void ofxThreadedVideo::closeMovie(){
     //waitForThread(); ?
+    
     lock();
-    ofxThreadedVideoGlobalMutex.lock();
     
+    // the worker (or update()) may be part way through a command with the
+    // players, so wait for it to leave the critical section and hold it
+    // while they close - unless it's us, eg., close() from a load listener
+    bool bOwnCriticalSection = bCriticalSection && criticalSectionThread == this_thread::get_id();
+    if(!bOwnCriticalSection){
+        // sleep on the mutex lock() already holds
+        ofScopedLock criticalLock(mutex, std::adopt_lock);
+        criticalSectionCondition.wait(criticalLock, [this]{ return !bCriticalSection; });
+        criticalLock.release();
+    }
+    bCriticalSection = true;
+    criticalSectionThread = this_thread::get_id();
+    unlock();
+    
+    // pending seeks etc are for the movie we're closing. cancelled as the
+    // consumer, now that we hold the critical section: close() may be
+    // called from a worker listener while the app thread is pushing
+    ofxThreadedVideoCommands.cancelPending(VIDEO_COMMAND_LANE_TRANSPORT);
+    
+    lockBackend();
     video[0].close();
     video[1].close();
+    unlockBackend();
     
-    bCriticalSection = false;
+    lock();
+    
+    if(!bOwnCriticalSection){
+        bCriticalSection = false;
+        criticalSectionCondition.notify_all();
+    }
     bLoaded = false;
+    endPlaylist();
     
     bUseTexture = true;
     bIsFrameNew = false;
@@ -753,7 +1962,7 @@ void ofxThreadedVideo::closeMovie(){
     prevMillis = ofGetElapsedTimeMillis();
     lastFrameTime = timeNow = timeThen = fps = frameRate = 0;
     
-    ofxThreadedVideoGlobalMutex.unlock();
+    publishState();
     unlock();
 }
 
@@ -761,24 +1970,24 @@ void ofxThreadedVideo::closeMovie(){
 void ofxThreadedVideo::setFade(float fadeTarget){
     ofScopedLock lock(mutex);
     _fade = fade = fadeTarget;
+    publishState();
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setFade(int frameStart, int durationMillis, float fadeTarget, bool fadeSound, bool fadeVideo, bool fadeOnce){
-    ofxThreadedVideoCommand c("setFade", instanceID);
-    c.setArgument(frameStart);
-    c.setArgument(durationMillis);
-    c.setArgument(fadeTarget);
-    c.setArgument(fadeSound);
-    c.setArgument(fadeVideo);
-    c.setArgument(fadeOnce);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_FADE, instanceID);
+    c.args.fade.frameStart = frameStart;
+    c.args.fade.durationMillis = durationMillis;
+    c.args.fade.fadeTarget = fadeTarget;
+    c.args.fade.fadeSound = fadeSound;
+    c.args.fade.fadeVideo = fadeVideo;
+    c.args.fade.fadeOnce = fadeOnce;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getFade(){
-    ofScopedLock lock(mutex);
-    return fade;
+    return publishedState.load().fade;
 }
 
 //--------------------------------------------------------------
@@ -795,92 +2004,85 @@ bool ofxThreadedVideo::isFrameNew(){
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getPosition(){
-    ofScopedLock lock(mutex);
-    return position;
+    return publishedState.load().position;
 }
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getSpeed(){
-    ofScopedLock lock(mutex);
-    return speed;
+    return publishedState.load().speed;
 }
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getDuration(){
-    ofScopedLock lock(mutex);
-    return duration;
+    return publishedState.load().duration;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::getIsMovieDone(){
-    ofScopedLock lock(mutex);
-    return bIsMovieDone;
+    return publishedState.load().bIsMovieDone;
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::setPosition(float _pct){
+ofxThreadedVideoHandle ofxThreadedVideo::setPosition(float _pct){
     _pct = CLAMP(_pct, 0.0f, 1.0f);
-    ofxThreadedVideoCommand c("setPosition", instanceID);
-    c.setArgument(_pct);
-    pushCommand(c);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_POSITION, instanceID);
+    c.args.value = _pct;
+    return pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setVolume(float _volume){
     _volume = CLAMP(_volume, 0.0f, 1.0f);
-    ofxThreadedVideoCommand c("setVolume", instanceID);
-    c.setArgument(_volume);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_VOLUME, instanceID);
+    c.args.value = _volume;
     pushCommand(c);
 }
 
 #ifdef USE_QUICKTIME_7
 //--------------------------------------------------------------
 float ofxThreadedVideo::getVolume(){ // we should implement for QT6
-    ofScopedLock lock(mutex);
-    return volume;
+    return publishedState.load().volume;
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setPan(float _pan){
     _pan = CLAMP(_pan, -1.0f, 1.0f);
-    ofxThreadedVideoCommand c("setPan", instanceID);
-    c.setArgument(_pan);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_PAN, instanceID);
+    c.args.value = _pan;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getPan(){
-    ofScopedLock lock(mutex);
-    return pan;
+    return publishedState.load().pan;
 }
 #endif
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setLoopState(ofLoopType state){
-    ofxThreadedVideoCommand c("setLoopState", instanceID);
-    c.setArgument(state);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_LOOP_STATE, instanceID);
+    c.args.loopState = state;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 int ofxThreadedVideo::getLoopState(){
-    ofScopedLock lock(mutex);
-    return loopState;
+    return publishedState.load().loopState;
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setSpeed(float _speed){
     _speed = CLAMP(_speed, -1.9, 4.0);
-    ofxThreadedVideoCommand c("setSpeed", instanceID);
-    c.setArgument(_speed);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_SPEED, instanceID);
+    c.args.value = _speed;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
-void ofxThreadedVideo::setFrame(int frame){
-    ofxThreadedVideoCommand c("setFrame", instanceID);
-    c.setArgument(frame);
-    pushCommand(c);
+ofxThreadedVideoHandle ofxThreadedVideo::setFrame(int frame){
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_FRAME, instanceID);
+    c.args.frame = frame;
+    return pushCommand(c);
 }
 
 //--------------------------------------------------------------
@@ -910,6 +2112,33 @@ ofPixelsRef ofxThreadedVideo::getPixelsRef(){
     return *pixels;
 }
 
+//--------------------------------------------------------------
+ofPixelsRef ofxThreadedVideo::getConvertedPixelsRef(ofPixelFormat pixelFormat){
+    ofScopedLock lock(mutex);
+    if(!ofxThreadedVideoConvert::isYUVPixelFormat(pixels->getPixelFormat())) return *pixels;
+    // the internal shaders are always drawn as 601
+    ofxThreadedVideoConvert::yuvToPixels(*pixels, convertedPixels, pixelFormat, 601);
+    return convertedPixels;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideo::loadPlaneTextures(const unsigned char * pixels, int frameWidth, int frameHeight){
+    
+    // same plane layout as ofPixels: Y, then U and V (or interleaved UV) at half size
+    int chromaWidth = frameWidth / 2;
+    int chromaHeight = frameHeight / 2;
+    const unsigned char * chroma = pixels + (size_t)frameWidth * frameHeight;
+    
+    drawTexture.loadData(pixels, frameWidth, frameHeight, GL_LUMINANCE);
+    if(chromaTextures[1].isAllocated()){
+        chromaTextures[0].loadData(chroma, chromaWidth, chromaHeight, GL_LUMINANCE);
+        chromaTextures[1].loadData(chroma + (size_t)chromaWidth * chromaHeight, chromaWidth, chromaHeight, GL_LUMINANCE);
+    }else{
+        chromaTextures[0].loadData(chroma, chromaWidth, chromaHeight, GL_LUMINANCE_ALPHA);
+    }
+    
+}
+
 //--------------------------------------------------------------
 ofShader& ofxThreadedVideo::getShader(){
     return shader;
@@ -954,17 +2183,25 @@ void ofxThreadedVideo::setPixelFormat(ofPixelFormat pixelFormat){
             pixelFormat = internalPixelFormat;
         }
         bUseInternalShader = true;
+    }else if(ofxThreadedVideoConvert::isPlanarPixelFormat(pixelFormat) && !planarShader.isLoaded()){
+        bool ok = planarShader.setupShaderFromSource(GL_VERTEX_SHADER, ofxThreadedVideoVertexShader);
+        if(ok) ok = planarShader.setupShaderFromSource(GL_FRAGMENT_SHADER, ofxThreadedVideoPlanarFragmentShader);
+        if(ok) ok = planarShader.linkProgram();
+        if(!ok){
+            ofLogError() << "Could not initialize planar shader - reverting to default pixel format";
+            pixelFormat = internalPixelFormat;
+        }
     }
     
     internalPixelFormat = pixelFormat;
+    publishState();
     video[0].setPixelFormat(internalPixelFormat);
     video[1].setPixelFormat(internalPixelFormat);
 }
 
 //--------------------------------------------------------------
 ofPixelFormat ofxThreadedVideo::getPixelFormat(){
-    ofScopedLock lock(mutex);
-    return internalPixelFormat;
+    return publishedState.load().pixelFormat;
 }
 
 //--------------------------------------------------------------
@@ -976,7 +2213,26 @@ ofPtr<ofBaseVideoPlayer> ofxThreadedVideo::getPlayer(){
 void ofxThreadedVideo::draw(float x, float y, float w, float h){
     ofPushStyle();
     
-    if(bUseInternalShader){
+    if(bPlanarTexture){
+        
+        // luma coordinates scaled onto the chroma textures (they only
+        // differ if the textures had to be padded to a power of two)
+        ofTextureData& lumaData = drawTexture.getTextureData();
+        ofTextureData& chromaData = chromaTextures[0].getTextureData();
+        bool bInterleavedChroma = !chromaTextures[1].isAllocated();
+        
+        planarShader.begin();
+        planarShader.setUniformTexture("yTex", drawTexture, 1);
+        planarShader.setUniformTexture("uTex", chromaTextures[0], 2);
+        planarShader.setUniformTexture("vTex", bInterleavedChroma ? chromaTextures[0] : chromaTextures[1], 3);
+        planarShader.setUniform2f("chromaScale", chromaData.tex_t / lumaData.tex_t, chromaData.tex_u / lumaData.tex_u);
+        planarShader.setUniform1i("interleavedChroma", bInterleavedChroma ? 1 : 0);
+        planarShader.setUniform1i("conversionType", 601);
+        planarShader.setUniform1f("fade", getFade());
+        drawTexture.draw(x, y, w, h);
+        planarShader.end();
+        
+    }else if(bUseInternalShader && !bTextureConverted){
         
         if(!fboYUY2.isAllocated()){
             ofPopStyle();
@@ -1028,43 +2284,41 @@ void ofxThreadedVideo::draw(){
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setAnchorPercent(float xPct, float yPct){
-    ofxThreadedVideoCommand c("setAnchorPercent", instanceID);
-    c.setArgument(xPct);
-    c.setArgument(yPct);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_ANCHOR_PERCENT, instanceID);
+    c.args.anchor.x = xPct;
+    c.args.anchor.y = yPct;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setAnchorPoint(float x, float y){
-    ofxThreadedVideoCommand c("setAnchorPoint", instanceID);
-    c.setArgument(x);
-    c.setArgument(y);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_ANCHOR_POINT, instanceID);
+    c.args.anchor.x = x;
+    c.args.anchor.y = y;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::resetAnchor(){
-    ofxThreadedVideoCommand c("resetAnchor", instanceID);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_RESET_ANCHOR, instanceID);
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setPaused(bool b){
-    ofxThreadedVideoCommand c("setPaused", instanceID);
-    c.setArgument(b);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_PAUSED, instanceID);
+    c.args.paused = b;
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 int ofxThreadedVideo::getCurrentFrame(){
-    ofScopedLock lock(mutex);
-    return frameCurrent;
+    return publishedState.load().frameCurrent;
 }
 
 //--------------------------------------------------------------
 int ofxThreadedVideo::getTotalNumFrames(){
-    ofScopedLock lock(mutex);
-    return frameTotal;
+    return publishedState.load().frameTotal;
 }
 
 //--------------------------------------------------------------
@@ -1084,35 +2338,32 @@ void ofxThreadedVideo::previousFrame(){
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getWidth(){
-    ofScopedLock lock(mutex);
-    return width;
+    return publishedState.load().width;
 }
 
 //--------------------------------------------------------------
 float ofxThreadedVideo::getHeight(){
-    ofScopedLock lock(mutex);
-    return height;
+    return publishedState.load().height;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isPaused(){
-    ofScopedLock lock(mutex);
-    return bIsPaused;
+    return publishedState.load().bIsPaused;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isLoading(){
-    ofScopedLock lock(mutex);
-    return bIsLoading;
+    return publishedState.load().bIsLoading;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isLoading(string path){
-    ofScopedLock lock(ofxThreadedVideoGlobalMutex);
-    for(int i = 0; i < ofxThreadedVideoCommands.size(); i++){
-        if(ofxThreadedVideoCommands[i].getInstance() == instanceID){
-            if(ofxThreadedVideoCommands[i].getCommand() == "loadMovie"){
-                if(ofxThreadedVideoCommands[i].getArgument<string>(0) == path){
+    int size = ofxThreadedVideoCommands.size();
+    for(int i = 0; i < size; i++){
+        const ofxThreadedVideoCommand& c = ofxThreadedVideoCommands.at(i);
+        if(c.getInstance() == instanceID){
+            if(c.getCommand() == VIDEO_COMMAND_LOAD){
+                if(path == c.getPath()){
                     return true;
                 }
             }
@@ -1123,20 +2374,17 @@ bool ofxThreadedVideo::isLoading(string path){
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isTextureReady(){
-    ofScopedLock lock(mutex);
-    return bIsTextureReady;
+    return publishedState.load().bIsTextureReady;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isLoaded(){
-    ofScopedLock lock(mutex);
-    return bLoaded;
+    return publishedState.load().bLoaded;
 }
 
 //--------------------------------------------------------------
 bool ofxThreadedVideo::isPlaying(){
-    ofScopedLock lock(mutex);
-    return bIsPlaying;
+    return publishedState.load().bIsPlaying;
 }
 
 //--------------------------------------------------------------
@@ -1153,17 +2401,14 @@ string ofxThreadedVideo::getMoviePath(){
 
 //--------------------------------------------------------------
 double ofxThreadedVideo::getFrameRate(){
-    ofScopedLock lock(mutex);
-    return frameRate;
+    return publishedState.load().frameRate;
 }
 
 #ifdef USE_JACK_AUDIO
 //--------------------------------------------------------------
 vector<string> ofxThreadedVideo::getAudioDevices(){
     lock();
-    ofxThreadedVideoGlobalMutex.lock();
     audioDevices = video[currentVideoID].getAudioDevices();
-    ofxThreadedVideoGlobalMutex.unlock();
     unlock();
     return audioDevices;
 }
@@ -1178,24 +2423,24 @@ vector<string> ofxThreadedVideo::getAudioDevices(){
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setAudioDevice(int deviceID){
-    ofxThreadedVideoCommand c("setAudioDevice", instanceID);
-    c.setArgument(deviceID);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_AUDIO_DEVICE, instanceID);
+    c.setPath(ofToString(deviceID));
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setAudioDevice(string deviceID){
-    ofxThreadedVideoCommand c("setAudioDevice", instanceID);
-    c.setArgument(deviceID);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_AUDIO_DEVICE, instanceID);
+    c.setPath(ofToString(deviceID));
     pushCommand(c);
 }
 
 //--------------------------------------------------------------
 void ofxThreadedVideo::setAudioTrackToChannel(int trackIndex, int oldChannelLabel, int newChannelLabel){
-    ofxThreadedVideoCommand c("setAudioTrackToChannel", instanceID);
-    c.setArgument(trackIndex);
-    c.setArgument(oldChannelLabel);
-    c.setArgument(newChannelLabel);
+    ofxThreadedVideoCommand c(VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL, instanceID);
+    c.args.audioTrack.trackIndex = trackIndex;
+    c.args.audioTrack.oldChannelLabel = oldChannelLabel;
+    c.args.audioTrack.newChannelLabel = newChannelLabel;
     pushCommand(c);
 }
 #endif
@@ -1228,5 +2473,8 @@ string ofxThreadedVideo::getEventTypeAsString(ofxThreadedVideoEventType eventTyp
         case VIDEO_EVENT_LOAD_FAIL:
             return "VIDEO_EVENT_LOAD_FAIL";
             break;
+        case VIDEO_EVENT_PLAYLIST_NEXT:
+            return "VIDEO_EVENT_PLAYLIST_NEXT";
+            break;
     }
 }
\ No newline at end of file
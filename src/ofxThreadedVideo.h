@@ -33,118 +33,28 @@
 #define __H_OFXTHREADEDVIDEO
 
 #include <set>
+#include <list>
+#include <map>
 #include <deque>
+#include <functional>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <assert.h>
 
 #include "ofMain.h"
-
-#if __LP64__
-
-#error ofxThreadedVideo support requires 32-bit QuickTime APIs but this target is 64-bit
-
-#else
+#include "ofxThreadedVideoPool.h"
+#include "ofxThreadedVideoBufferPool.h"
+#include "ofxThreadedVideoConvert.h"
+#include "ofxThreadedVideoMetadataCache.h"
+#include "ofxThreadedVideoQuickTimePlayer.h"
+#include "ofxThreadedVideoY4MPlayer.h"
+#include "ofxThreadedVideoRawPlayer.h"
+#include "ofxThreadedVideoImageSequencePlayer.h"
 
 //#define USE_QUICKTIME_7
 //#define USE_JACK_AUDIO
 
-#include "ofQtUtils.h"
-#include "ofQuickTimePlayer.h"
-
-// class implimentation overrides how ofQuicktimePlayer implements pixel
-// decoding and allows setPixels for RGB, RGBA, BGRA and YUY2 pixel formats
-class ofQuickTimePlayerWithFastPixels: public ofQuickTimePlayer{
-    
-public:
-    
-void createImgMemAndGWorld(){
-    
-    Rect movieRect;
-    movieRect.top 			= 0;
-    movieRect.left 			= 0;
-    movieRect.bottom 		= height;
-    movieRect.right 		= width;
-    
-    switch(internalPixelFormat){
-            
-        case OF_PIXELS_RGB:
-        {
-            offscreenGWorldPixels = new unsigned char[3 * width * height + 24];
-            pixels.allocate(width, height, OF_PIXELS_RGB);
-            QTNewGWorldFromPtr (&(offscreenGWorld), k24RGBPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 3 * width);
-            break;
-        }
-        case OF_PIXELS_RGBA:
-        {
-            offscreenGWorldPixels = new unsigned char[4 * width * height + 32];
-            pixels.allocate(width, height, OF_PIXELS_RGBA);
-            QTNewGWorldFromPtr (&(offscreenGWorld), k32RGBAPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
-            break;
-        }
-        case OF_PIXELS_BGRA:
-        {
-            offscreenGWorldPixels = new unsigned char[4 * width * height + 32];
-            pixels.allocate(width, height, OF_PIXELS_BGRA);
-            QTNewGWorldFromPtr (&(offscreenGWorld), k32BGRAPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
-            break;
-        }
-        case OF_PIXELS_YUY2:
-        {
-#if !defined (TARGET_OSX) && !defined (GL_APPLE_rgb_422)
-            movieRect.right = width*2; // this makes it look correct but we lose some of the performance gains
-            SetMovieBox(moviePtr, &(movieRect));
-            //width = width / 2; // this makes it go really fast but we only get 'half-resolution'...
-            offscreenGWorldPixels = new unsigned char[4 * width * height + 32];
-            pixels.allocate(width, height, OF_IMAGE_COLOR_ALPHA);
-            QTNewGWorldFromPtr (&(offscreenGWorld), k24RGBPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
-#else
-            
-            // for some reason doesn't like non-even width's and height's
-            if(width % 2 != 0) width++;
-            if(height % 2 != 0) height++;
-            movieRect.bottom = height;
-            movieRect.right = width;
-            
-            // this works perfectly on Mac platform!
-            offscreenGWorldPixels = new unsigned char[2 * width * height + 32];
-            pixels.allocate(width, height, OF_IMAGE_COLOR_ALPHA);
-            QTNewGWorldFromPtr (&(offscreenGWorld), k2vuyPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 2 * width);
-#endif
-            
-            break;
-        }
-    }
-    
-    LockPixels(GetGWorldPixMap(offscreenGWorld));
-    
-    // from : https://github.com/openframeworks/openFrameworks/issues/244
-    // SetGWorld do not seems to be necessary for offscreen rendering of the movie
-    // only SetMovieGWorld should be called
-    // if both are called, the app will crash after a few ofVideoPlayer object have been deleted
-    
-#ifndef TARGET_WIN32
-    SetGWorld (offscreenGWorld, NULL);
-#endif
-    SetMovieGWorld (moviePtr, offscreenGWorld, nil);
-    
-}
-    
-//---------------------------------------------------------------------------
-bool setPixelFormat(ofPixelFormat pixelFormat){
-    //note as we only support RGB we are just confirming that this pixel format is supported
-    if( pixelFormat == OF_PIXELS_RGB || pixelFormat == OF_PIXELS_RGBA || pixelFormat == OF_PIXELS_BGRA || pixelFormat == OF_PIXELS_YUY2){
-        internalPixelFormat = pixelFormat;
-        return true;
-    }
-    ofLogWarning("ofQuickTimePlayer") << "setPixelFormat(): requested pixel format " << pixelFormat << " not supported";
-    return false;
-}
-    
-protected:
-    
-    int internalPixelFormat;
-    
-};
-
 // YUV2 shader modified from: http://www.fourcc.org/fccyvrgb.php and http://www.fourcc.org/source/YUV420P-OpenGL-GLSLang.c
 const string ofxThreadedVideoVertexShader = "void main(void){\
 gl_TexCoord[0] = gl_MultiTexCoord0;\
@@ -179,9 +89,48 @@ b = y + c * (1.0 - kb) * u;\
 gl_FragColor = vec4(r * fade, g * fade, b * fade, 1.0 * fade);\
 }";
 
+// I420 and NV12 frames upload as a luma texture plus half size chroma
+// texture(s) (GL_LUMINANCE for U and V, GL_LUMINANCE_ALPHA for NV12's UV)
+// and are put back together here with the same math as the YUY2 shader
+const string ofxThreadedVideoPlanarFragmentShader = "uniform sampler2D yTex;\
+uniform sampler2D uTex;\
+uniform sampler2D vTex;\
+uniform vec2 chromaScale;\
+uniform int interleavedChroma;\
+uniform int conversionType;\
+uniform float fade;\
+void main(void){\
+float r, g, b, y, u, v;\
+vec2 chromaCoord = gl_TexCoord[0].xy * chromaScale;\
+y = texture2D(yTex, gl_TexCoord[0].xy).r;\
+if(interleavedChroma == 1){\
+vec4 uv = texture2D(uTex, chromaCoord);\
+u = uv.r;\
+v = uv.a;\
+}else{\
+u = texture2D(uTex, chromaCoord).r;\
+v = texture2D(vTex, chromaCoord).r;\
+}\
+y = 1.164383561643836 * (y - 0.0625);\
+u = u - 0.5;\
+v = v - 0.5;\
+float kb = 0.114;\
+float kr = 0.299;\
+float c = 2.276785714285714;\
+if(conversionType == 709){\
+kb = 0.0722;\
+kr = 0.2126;\
+}\
+r = y + c * (1.0 - kr) * v;\
+g = y - c * (1.0 - kb) * (kb / (1.0 - kb - kr)) * u - c * (1.0 - kr) * (kr / (1.0 - kb - kr)) * v;\
+b = y + c * (1.0 - kb) * u;\
+gl_FragColor = vec4(r * fade, g * fade, b * fade, 1.0 * fade);\
+}";
+
 enum ofxThreadedVideoEventType{
     VIDEO_EVENT_LOAD_OK = 0,
-    VIDEO_EVENT_LOAD_FAIL
+    VIDEO_EVENT_LOAD_FAIL,
+    VIDEO_EVENT_PLAYLIST_NEXT
 };
 
 #ifdef USE_JACK_AUDIO
@@ -193,6 +142,16 @@ struct AudioChannelMap{
 #endif
 
 class ofxThreadedVideo;
+
+// a frame the worker decoded ahead, waiting in the ring for update()
+struct ofxThreadedVideoFrame {
+    ofPixels * pixels;
+    int frameCurrent;
+    float position;
+    bool bIsMovieDone;
+    bool bBlack;    // a black stop frame, update() unloads once it's shown
+    unsigned long long timeDue;
+};
 class ofxThreadedVideoEvent;
 
 class ofxThreadedVideoFade {
@@ -251,113 +210,999 @@ public:
     
 };
 
+#ifndef OFX_THREADED_VIDEO_MAX_PATHS
+#define OFX_THREADED_VIDEO_MAX_PATHS 65536 // distinct paths interned per process
+#endif
+
+// paths are too big to ride in a command slot, so commands carry an index
+// into this process-wide table instead. each distinct path is stored once
+// and kept for the life of the process; index 0 is the empty path
+class ofxThreadedVideoPathTable {
+    
+public:
+    
+    // returns 0 once the table is full
+    static int intern(const string& path){
+        ofxThreadedVideoPathTable& table = getTable();
+        ofScopedLock lock(table.mutex);
+        map<string, int>::iterator it = table.ids.find(path);
+        if(it != table.ids.end()) return it->second;
+        if(table.paths.size() >= OFX_THREADED_VIDEO_MAX_PATHS) return 0;
+        int id = table.paths.size();
+        table.paths.push_back(path);
+        table.ids[path] = id;
+        return id;
+    }
+    
+    static string lookup(int id){
+        ofxThreadedVideoPathTable& table = getTable();
+        ofScopedLock lock(table.mutex);
+        if(id <= 0 || id >= (int)table.paths.size()) return "";
+        return table.paths[id];
+    }
+    
+private:
+    
+    ofxThreadedVideoPathTable(){
+        paths.push_back("");
+        ids[""] = 0;
+    }
+    
+    static ofxThreadedVideoPathTable& getTable(){
+        static ofxThreadedVideoPathTable table;
+        return table;
+    }
+    
+    ofMutex mutex;
+    vector<string> paths;
+    map<string, int> ids;
+    
+};
+
+enum ofxThreadedVideoCommandType{
+    VIDEO_COMMAND_NULL = 0,
+    VIDEO_COMMAND_LOAD,
+    VIDEO_COMMAND_PLAY,
+    VIDEO_COMMAND_STOP,
+    VIDEO_COMMAND_SET_PAUSED,
+    VIDEO_COMMAND_SET_SPEED,
+    VIDEO_COMMAND_SET_FRAME,
+    VIDEO_COMMAND_SET_POSITION,
+    VIDEO_COMMAND_SET_VOLUME,
+    VIDEO_COMMAND_SET_PAN,
+    VIDEO_COMMAND_SET_LOOP_STATE,
+    VIDEO_COMMAND_SET_ANCHOR_PERCENT,
+    VIDEO_COMMAND_SET_ANCHOR_POINT,
+    VIDEO_COMMAND_RESET_ANCHOR,
+    VIDEO_COMMAND_SET_FADE,
+    VIDEO_COMMAND_SET_AUDIO_DEVICE,
+    VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL,
+    VIDEO_COMMAND_PRELOAD,
+    VIDEO_COMMAND_SET_PLAYLIST
+};
+
+// commands are queued in one of three lanes and the consumer always takes
+// the head of the highest non-empty lane, so a load or stop doesn't wait
+// behind a backlog of seeks. the one exception is that control commands
+// (and batches, which go in the control lane) never overtake anything still
+// queued before them: a setVolume() called before loadMovie() still reaches
+// the old movie, and a setPaused() before a batch can't undo the batch.
+// transport commands queued before a load, stop or playlist are cancelled
+enum ofxThreadedVideoCommandLane{
+    VIDEO_COMMAND_LANE_CONTROL = 0,     // load, stop
+    VIDEO_COMMAND_LANE_TRANSPORT,       // play, pause, seek, speed, loop state
+    VIDEO_COMMAND_LANE_COSMETIC,        // anchor, fade, volume, pan, audio routing
+    VIDEO_COMMAND_LANE_COUNT
+};
+
+// commands are plain fixed size structs: an opcode plus a tagged union
+// of arguments, so building, copying and dispatching them never touches
+// the heap or compares strings (paths live in ofxThreadedVideoPathTable)
 class ofxThreadedVideoCommand {
     
 public:
     
     ofxThreadedVideoCommand(){
-        setCommand("NULL_COMMAND", -1);
+        setCommand(VIDEO_COMMAND_NULL, -1);
     }
-    ofxThreadedVideoCommand(string _command, int _instanceID){
+    ofxThreadedVideoCommand(ofxThreadedVideoCommandType _command, int _instanceID){
         setCommand(_command, _instanceID);
     }
-    ~ofxThreadedVideoCommand(){
-        instanceID = -1;
-        command.clear();
-        args.clear();
-    }
     
-    void setCommand(string _command, int _instanceID){
+    void setCommand(ofxThreadedVideoCommandType _command, int _instanceID){
         instanceID = _instanceID;
         command = _command;
+        timeQueued = 0;
+        sequence = 0;
+        groupSize = 0;
+        handleSlot = -1;
+        memset(&args, 0, sizeof(args));
     }
     
-    int getInstance(){
+    int getInstance() const{
         return instanceID;
     }
     
-    string getCommand(){
+    ofxThreadedVideoCommandType getCommand() const{
         return command;
     }
     
-    template<typename T>
-    void setArgument(T arg){
-        args.push_back(ofToString(arg));
+    bool setPath(const string& path){
+        args.pathID = ofxThreadedVideoPathTable::intern(path);
+        if(args.pathID == 0 && path.size() > 0){
+            ofLogError() << "Too many distinct paths (" << OFX_THREADED_VIDEO_MAX_PATHS << ") to queue " << path;
+            return false;
+        }
+        return true;
     }
     
-    template<typename T>
-    T getArgument(int index){
-        if(index > args.size() || index < 0){
-            ofLogError() << "Argument index out of range: " << index << " : " << args.size();
-            return NULL;
+    string getPath() const{
+        return ofxThreadedVideoPathTable::lookup(args.pathID);
+    }
+    
+    string getCommandAsString() const{
+        ostringstream os;
+        os << getCommandName(command) << "(";
+        switch(command){
+            case VIDEO_COMMAND_LOAD:
+            case VIDEO_COMMAND_SET_AUDIO_DEVICE:
+            case VIDEO_COMMAND_PRELOAD:
+                os << getPath();
+                break;
+            case VIDEO_COMMAND_SET_PAUSED:
+                os << args.paused;
+                break;
+            case VIDEO_COMMAND_SET_FRAME:
+            case VIDEO_COMMAND_SET_PLAYLIST:
+                os << args.frame;
+                break;
+            case VIDEO_COMMAND_SET_LOOP_STATE:
+                os << args.loopState;
+                break;
+            case VIDEO_COMMAND_SET_SPEED:
+            case VIDEO_COMMAND_SET_POSITION:
+            case VIDEO_COMMAND_SET_VOLUME:
+            case VIDEO_COMMAND_SET_PAN:
+                os << args.value;
+                break;
+            case VIDEO_COMMAND_SET_ANCHOR_PERCENT:
+            case VIDEO_COMMAND_SET_ANCHOR_POINT:
+                os << args.anchor.x << "," << args.anchor.y;
+                break;
+            case VIDEO_COMMAND_SET_FADE:
+                os << args.fade.frameStart << "," << args.fade.durationMillis << "," << args.fade.fadeTarget << ","
+                   << args.fade.fadeSound << "," << args.fade.fadeVideo << "," << args.fade.fadeOnce;
+                break;
+            case VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL:
+                os << args.audioTrack.trackIndex << "," << args.audioTrack.oldChannelLabel << "," << args.audioTrack.newChannelLabel;
+                break;
+            default:
+                break;
         }
-        return getArgument(index, T());
+        os << ")";
+        return os.str();
     }
     
-    string getArgument(int index, string t){
-        return args[index];
+    ofxThreadedVideoCommandLane getLane() const{
+        switch(command){
+            case VIDEO_COMMAND_LOAD:
+            case VIDEO_COMMAND_STOP:
+            case VIDEO_COMMAND_SET_PLAYLIST:
+                return VIDEO_COMMAND_LANE_CONTROL;
+            case VIDEO_COMMAND_PLAY:
+            case VIDEO_COMMAND_SET_PAUSED:
+            case VIDEO_COMMAND_SET_SPEED:
+            case VIDEO_COMMAND_SET_FRAME:
+            case VIDEO_COMMAND_SET_POSITION:
+            case VIDEO_COMMAND_SET_LOOP_STATE:
+                return VIDEO_COMMAND_LANE_TRANSPORT;
+            default:
+                return VIDEO_COMMAND_LANE_COSMETIC;
+        }
     }
     
-    int getArgument(int index, int t){
-        return ofToInt(args[index]);
+    // commands that only set a value can be coalesced last-writer-wins with
+    // a still pending command of the same key; setFrame and setPosition share
+    // a key as they both seek. returns VIDEO_COMMAND_NULL for everything else
+    ofxThreadedVideoCommandType getCoalesceKey() const{
+        switch(command){
+            case VIDEO_COMMAND_SET_FRAME:
+            case VIDEO_COMMAND_SET_POSITION:
+                return VIDEO_COMMAND_SET_FRAME;
+            case VIDEO_COMMAND_SET_SPEED:
+            case VIDEO_COMMAND_SET_VOLUME:
+            case VIDEO_COMMAND_SET_PAN:
+            case VIDEO_COMMAND_SET_LOOP_STATE:
+                return command;
+            default:
+                return VIDEO_COMMAND_NULL;
+        }
     }
     
-    float getArgument(int index, float t){
-        return ofToFloat(args[index]);
+    static const char * getCommandName(ofxThreadedVideoCommandType command){
+        switch(command){
+            case VIDEO_COMMAND_NULL:                        return "NULL_COMMAND";
+            case VIDEO_COMMAND_LOAD:                        return "loadMovie";
+            case VIDEO_COMMAND_PLAY:                        return "play";
+            case VIDEO_COMMAND_STOP:                        return "stop";
+            case VIDEO_COMMAND_SET_PAUSED:                  return "setPaused";
+            case VIDEO_COMMAND_SET_SPEED:                   return "setSpeed";
+            case VIDEO_COMMAND_SET_FRAME:                   return "setFrame";
+            case VIDEO_COMMAND_SET_POSITION:                return "setPosition";
+            case VIDEO_COMMAND_SET_VOLUME:                  return "setVolume";
+            case VIDEO_COMMAND_SET_PAN:                     return "setPan";
+            case VIDEO_COMMAND_SET_LOOP_STATE:              return "setLoopState";
+            case VIDEO_COMMAND_SET_ANCHOR_PERCENT:          return "setAnchorPercent";
+            case VIDEO_COMMAND_SET_ANCHOR_POINT:            return "setAnchorPoint";
+            case VIDEO_COMMAND_RESET_ANCHOR:                return "resetAnchor";
+            case VIDEO_COMMAND_SET_FADE:                    return "setFade";
+            case VIDEO_COMMAND_SET_AUDIO_DEVICE:            return "setAudioDevice";
+            case VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL:  return "setAudioTrackToChannel";
+            case VIDEO_COMMAND_PRELOAD:                     return "preload";
+            case VIDEO_COMMAND_SET_PLAYLIST:                return "setPlaylist";
+        }
+        return "UNKNOWN_COMMAND";
     }
     
-    bool getArgument(int index, bool t){
-        return ofToBool(args[index]);
+    // stamped by pushCommand(), used for latency stats
+    unsigned long long timeQueued;
+    
+    // stamped by ofxThreadedVideoCommandLanes::push(), orders commands across lanes
+    unsigned int sequence;
+    
+    // commands submitted in a batch count down to 1 for the last in the group, 0 = not batched
+    int groupSize;
+    
+    // slot in the instance's ofxThreadedVideoHandleTable, -1 = none
+    int handleSlot;
+    
+    union {
+        int frame;
+        float value;
+        bool paused;
+        int loopState;
+        struct { float x; float y; } anchor;
+        struct { int frameStart; int durationMillis; float fadeTarget; bool fadeSound; bool fadeVideo; bool fadeOnce; } fade;
+        struct { int trackIndex; int oldChannelLabel; int newChannelLabel; } audioTrack;
+        int pathID;
+    } args;
+    
+private:
+    
+    int instanceID;
+    ofxThreadedVideoCommandType command;
+    
+};
+
+#ifndef OFX_THREADED_VIDEO_LATENCY_SAMPLES
+#define OFX_THREADED_VIDEO_LATENCY_SAMPLES 1024
+#endif
+
+#ifndef OFX_THREADED_VIDEO_QUEUE_SIZE
+#define OFX_THREADED_VIDEO_QUEUE_SIZE 128 // must be a power of two
+#endif
+
+enum ofxThreadedVideoHandleStatus{
+    VIDEO_HANDLE_INVALID = 0,   // default constructed
+    VIDEO_HANDLE_PENDING,
+    VIDEO_HANDLE_RUNNING,
+    VIDEO_HANDLE_DONE,
+    VIDEO_HANDLE_FAILED,        // load failed or the queue was full
+    VIDEO_HANDLE_CANCELLED,     // superseded by a coalesced command, cancelled by load/stop or flushed
+    VIDEO_HANDLE_EXPIRED        // finished so long ago its slot has been reused
+};
+
+// a slot can't be reused while its command is pending as all three lanes
+// together hold fewer commands than this
+#define OFX_THREADED_VIDEO_HANDLE_SLOTS (4 * OFX_THREADED_VIDEO_QUEUE_SIZE)
+
+// completion state for queued commands. slots are allocated round robin by
+// the producer and written by whoever is consuming; readers check the slot
+// generation after reading so a reused slot reads as VIDEO_HANDLE_EXPIRED.
+// shared (ofPtr) between an instance and its handles so handles can outlive it
+class ofxThreadedVideoHandleTable {
+    
+public:
+    
+    ofxThreadedVideoHandleTable(){
+        nextSlot = 0;
+        waiters = 0;
+        for(int i = 0; i < OFX_THREADED_VIDEO_HANDLE_SLOTS; i++){
+            slots[i].generation = 0;
+            slots[i].status = VIDEO_HANDLE_INVALID;
+            slots[i].timeQueued = slots[i].timeStarted = slots[i].timeFinished = 0;
+        }
     }
     
-    int getNumArguments(){
-        return args.size();
+    // producer side
+    int allocate(unsigned int& generation, unsigned long long timeQueued){
+        int index = nextSlot;
+        nextSlot = (nextSlot + 1) % OFX_THREADED_VIDEO_HANDLE_SLOTS;
+        Slot& slot = slots[index];
+        generation = slot.generation.load(std::memory_order_relaxed) + 1;
+        slot.generation.store(generation, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timeQueued.store(timeQueued, std::memory_order_relaxed);
+        slot.timeStarted.store(0, std::memory_order_relaxed);
+        slot.timeFinished.store(0, std::memory_order_relaxed);
+        slot.status.store(VIDEO_HANDLE_PENDING, std::memory_order_release);
+        return index;
     }
     
-    string getCommandAsString(){
-        ostringstream os;
-        os << command << "(";
-        for(int i = 0; i < args.size(); i++){
-            os << args[i] << string(i < args.size() - 1 ? "," : "");
+    // consumer (or cancelling producer) side
+    void start(int index, unsigned long long timeStarted){
+        if(index < 0) return;
+        Slot& slot = slots[index];
+        if(slot.status.load(std::memory_order_relaxed) != VIDEO_HANDLE_PENDING) return;
+        slot.timeStarted.store(timeStarted, std::memory_order_relaxed);
+        slot.status.store(VIDEO_HANDLE_RUNNING, std::memory_order_release);
+    }
+    
+    void finish(int index, ofxThreadedVideoHandleStatus status, unsigned long long timeStarted, unsigned long long timeFinished){
+        if(index < 0) return;
+        Slot& slot = slots[index];
+        if(slot.timeStarted.load(std::memory_order_relaxed) == 0) slot.timeStarted.store(timeStarted, std::memory_order_relaxed);
+        slot.timeFinished.store(timeFinished, std::memory_order_relaxed);
+        slot.status.store(status);
+        // only pay for the lock and notify if somebody is actually waiting
+        if(waiters.load() > 0){
+            ofScopedLock lock(waitMutex);
+            waitCondition.notify_all();
         }
-        os << ")";
-        return os.str();
+    }
+    
+    // handle side
+    ofxThreadedVideoHandleStatus getStatus(int index, unsigned int generation) const{
+        const Slot& slot = slots[index];
+        int status = slot.status.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.generation.load(std::memory_order_relaxed) != generation) return VIDEO_HANDLE_EXPIRED;
+        return (ofxThreadedVideoHandleStatus)status;
+    }
+    
+    unsigned long long getTime(int index, unsigned int generation, int which) const{
+        const Slot& slot = slots[index];
+        unsigned long long time = (which == 0 ? slot.timeQueued : (which == 1 ? slot.timeStarted : slot.timeFinished)).load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.generation.load(std::memory_order_relaxed) != generation) return 0;
+        return time;
+    }
+    
+    bool isDone(int index, unsigned int generation) const{
+        return getStatus(index, generation) >= VIDEO_HANDLE_DONE;
+    }
+    
+    bool wait(int index, unsigned int generation, int timeoutMillis){
+        if(isDone(index, generation)) return true;
+        waiters++;
+        bool bDone;
+        {
+            ofScopedLock lock(waitMutex);
+            if(timeoutMillis < 0){
+                waitCondition.wait(lock, [&]{ return isDone(index, generation); });
+                bDone = true;
+            }else{
+                bDone = waitCondition.wait_for(lock, std::chrono::milliseconds(timeoutMillis), [&]{ return isDone(index, generation); });
+            }
+        }
+        waiters--;
+        return bDone;
     }
     
 private:
     
-    int instanceID;
-    string command;
-    vector<string> args;
+    struct Slot {
+        std::atomic<unsigned int> generation;
+        std::atomic<int> status;
+        std::atomic<unsigned long long> timeQueued;
+        std::atomic<unsigned long long> timeStarted;
+        std::atomic<unsigned long long> timeFinished;
+    };
+    
+    Slot slots[OFX_THREADED_VIDEO_HANDLE_SLOTS];
+    int nextSlot;
+    
+    std::atomic<int> waiters;
+    ofMutex waitMutex;
+    std::condition_variable waitCondition;
+    
+};
+
+// returned by load(), setFrame() and setPosition(). it's a couple of words
+// and cheap to copy; polling never locks, wait() sleeps on a condition
+// variable. times are ofGetElapsedTimeMicros(), 0 until reached.
+// NB: loads (and the commands update() executes) need update() to keep
+// being called, so don't wait() on them from the thread that calls update()
+class ofxThreadedVideoHandle {
+    
+public:
+    
+    ofxThreadedVideoHandle(){
+        slot = -1;
+        generation = 0;
+    }
+    ofxThreadedVideoHandle(ofPtr<ofxThreadedVideoHandleTable> _table, int _slot, unsigned int _generation)
+    : table(_table), slot(_slot), generation(_generation){}
+    
+    bool isValid() const{
+        return slot >= 0 && table;
+    }
+    
+    ofxThreadedVideoHandleStatus getStatus() const{
+        if(!isValid()) return VIDEO_HANDLE_INVALID;
+        return table->getStatus(slot, generation);
+    }
+    
+    // done, failed, cancelled or expired - ie., nothing more will happen
+    bool isDone() const{
+        return getStatus() >= VIDEO_HANDLE_DONE;
+    }
+    
+    // timeoutMillis < 0 waits forever; returns isDone()
+    bool wait(int timeoutMillis = -1) const{
+        if(!isValid()) return true;
+        return table->wait(slot, generation, timeoutMillis);
+    }
+    
+    unsigned long long getTimeQueued() const{
+        return isValid() ? table->getTime(slot, generation, 0) : 0;
+    }
+    
+    unsigned long long getTimeStarted() const{
+        return isValid() ? table->getTime(slot, generation, 1) : 0;
+    }
+    
+    unsigned long long getTimeFinished() const{
+        return isValid() ? table->getTime(slot, generation, 2) : 0;
+    }
+    
+private:
+    
+    ofPtr<ofxThreadedVideoHandleTable> table;
+    int slot;
+    unsigned int generation;
+    
+};
+
+// bounded single producer/single consumer ring of commands, one per instance.
+//
+// the producer is the thread calling the ofxThreadedVideo API (normally the
+// app's main thread); the consumer is whichever of update() or the worker
+// currently owns the instance's critical section, so only one of them ever
+// touches the head at a time. neither side takes a lock.
+//
+// overflow policy: push() never blocks the caller. if the ring is full the
+// new command is dropped, counted (getOverflowCount()) and logged as an error
+//
+// coalescing: before pushing, the producer may instead overwrite a pending
+// command with the same coalesce key (see getCoalesceKey()). it only looks
+// back as far as the last command that isn't coalescable, so ordering around
+// load/play/stop etc is kept. each slot has a state so the producer can't
+// rewrite a command the consumer has already claimed with claimFront().
+//
+// the producer can also cancel everything pending (cancelPending()); the
+// consumer pops cancelled slots without returning them
+class ofxThreadedVideoCommandQueue {
+    
+public:
+    
+    enum SlotState {
+        SLOT_PUBLISHED = 0,
+        SLOT_WRITING,
+        SLOT_CLAIMED,
+        SLOT_CANCELLED
+    };
+    
+    ofxThreadedVideoCommandQueue(){
+        head = 0;
+        tail = 0;
+        batchTail = 0;
+        bBatching = bBatchFailed = false;
+        handles = NULL;
+        overflowCount = 0;
+        coalescedCount = 0;
+        cancelledCount = 0;
+        for(int i = 0; i < OFX_THREADED_VIDEO_QUEUE_SIZE; i++) states[i] = SLOT_PUBLISHED;
+    }
+    
+    // producer side
+    bool push(const ofxThreadedVideoCommand& c, unsigned int sequence = 0){
+        unsigned int t = bBatching ? batchTail : tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) >= OFX_THREADED_VIDEO_QUEUE_SIZE){
+            overflowCount++;
+            if(bBatching) bBatchFailed = true;
+            return false;
+        }
+        commands[t & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)] = c;
+        commands[t & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].sequence = sequence;
+        states[t & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].store(SLOT_PUBLISHED, std::memory_order_relaxed);
+        if(bBatching){
+            batchTail = t + 1;
+        }else{
+            tail.store(t + 1, std::memory_order_release);
+        }
+        return true;
+    }
+    
+    // producer side: between beginBatch() and endBatch() push() writes past
+    // the tail without publishing; endBatch() stamps the group sizes and
+    // publishes the lot with one store. if any of it didn't fit none of it is
+    // published and endBatch() returns false
+    void beginBatch(){
+        batchTail = tail.load(std::memory_order_relaxed);
+        bBatching = true;
+        bBatchFailed = false;
+    }
+    
+    bool endBatch(){
+        bBatching = false;
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        if(bBatchFailed){
+            for(unsigned int i = t; i != batchTail; i++) finishHandle(commands[i & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)], VIDEO_HANDLE_FAILED);
+            return false;
+        }
+        int count = batchTail - t;
+        for(int i = 0; i < count; i++){
+            commands[(t + i) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].groupSize = count - i;
+        }
+        tail.store(batchTail, std::memory_order_release);
+        return true;
+    }
+    
+    // producer side: returns true if c was folded into a pending command
+    // queued at or after barrier (a sequence number)
+    bool coalesce(const ofxThreadedVideoCommand& c, unsigned int barrier = 0){
+        ofxThreadedVideoCommandType key = c.getCoalesceKey();
+        if(key == VIDEO_COMMAND_NULL) return false;
+        unsigned int h = head.load(std::memory_order_acquire);
+        for(unsigned int t = tail.load(std::memory_order_relaxed); t != h; t--){
+            int index = (t - 1) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1);
+            ofxThreadedVideoCommand& pending = commands[index];
+            if((int)(pending.sequence - barrier) < 0) return false; // older than the barrier
+            ofxThreadedVideoCommandType pendingKey = pending.getCoalesceKey();
+            if(pendingKey == VIDEO_COMMAND_NULL) return false; // can't reorder past this one
+            if(pendingKey != key) continue;
+            int expected = SLOT_PUBLISHED;
+            if(!states[index].compare_exchange_strong(expected, SLOT_WRITING, std::memory_order_acquire)) return false; // consumer has it or it's cancelled
+            // keep the original timeQueued so latency shows how long the slot waited
+            unsigned long long timeQueued = pending.timeQueued;
+            unsigned int sequence = pending.sequence;
+            finishHandle(pending, VIDEO_HANDLE_CANCELLED);
+            pending.setCommand(c.getCommand(), c.getInstance());
+            memcpy(&pending.args, &c.args, sizeof(c.args));
+            pending.timeQueued = timeQueued;
+            pending.sequence = sequence;
+            pending.handleSlot = c.handleSlot;
+            states[index].store(SLOT_PUBLISHED, std::memory_order_release);
+            coalescedCount++;
+            return true;
+        }
+        return false;
+    }
+    
+    // producer side: cancels every pending command the consumer hasn't
+    // claimed or, if keys is set, only those whose coalesce key is flagged.
+    // without keys the consumer can call it too (like clear()), as a slot
+    // is only read once it's been won from the producer
+    void cancelPending(const bool * keys = NULL){
+        unsigned int t = tail.load(std::memory_order_acquire);
+        for(unsigned int h = head.load(std::memory_order_acquire); h != t; h++){
+            if(keys != NULL && !keys[commands[h & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].getCoalesceKey()]) continue;
+            int expected = SLOT_PUBLISHED;
+            if(states[h & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].compare_exchange_strong(expected, SLOT_CANCELLED, std::memory_order_acquire)){
+                finishHandle(commands[h & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)], VIDEO_HANDLE_CANCELLED);
+                cancelledCount++;
+            }
+        }
+    }
+    
+    // consumer side: copies the head command into c and stops the producer
+    // coalescing into it until it's either popped or released with unclaimFront()
+    bool claimFront(ofxThreadedVideoCommand& c){
+        while(size() > 0){
+            int index = head.load(std::memory_order_relaxed) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1);
+            int expected = SLOT_PUBLISHED;
+            while(!states[index].compare_exchange_weak(expected, SLOT_CLAIMED, std::memory_order_acquire)){
+                if(expected == SLOT_CANCELLED) break;
+                // only ever SLOT_WRITING for the few stores in coalesce()
+                expected = SLOT_PUBLISHED;
+                std::this_thread::yield();
+            }
+            if(expected == SLOT_CANCELLED){
+                pop();
+                continue;
+            }
+            c = commands[index];
+            return true;
+        }
+        return false;
+    }
+    
+    void unclaimFront(){
+        states[head.load(std::memory_order_relaxed) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].store(SLOT_PUBLISHED, std::memory_order_release);
+    }
+    
+    // consumer side: front() is only valid while size() > 0
+    const ofxThreadedVideoCommand& front() const{
+        return commands[head.load(std::memory_order_relaxed) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)];
+    }
+    
+    void pop(){
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    void clear(){
+        unsigned int t = tail.load(std::memory_order_acquire);
+        for(unsigned int h = head.load(std::memory_order_relaxed); h != t; h++){
+            // cancel first so the producer can't coalesce into it while we finish its handle
+            int expected = SLOT_PUBLISHED;
+            if(states[h & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)].compare_exchange_strong(expected, SLOT_CANCELLED, std::memory_order_acquire)){
+                finishHandle(commands[h & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)], VIDEO_HANDLE_CANCELLED);
+            }
+        }
+        head.store(t, std::memory_order_release);
+    }
+    
+    void setHandleTable(ofxThreadedVideoHandleTable * _handles){
+        handles = _handles;
+    }
+    
+    void finishHandle(const ofxThreadedVideoCommand& c, ofxThreadedVideoHandleStatus status){
+        if(handles == NULL) return;
+        unsigned long long timeNow = ofGetElapsedTimeMicros();
+        handles->finish(c.handleSlot, status, timeNow, timeNow);
+    }
+    
+    // safe from either side; the producer may also walk [0, size()) with at()
+    int size() const{
+        return (int)(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+    
+    const ofxThreadedVideoCommand& at(int index) const{
+        return commands[(head.load(std::memory_order_acquire) + index) & (OFX_THREADED_VIDEO_QUEUE_SIZE - 1)];
+    }
+    
+    int getOverflowCount() const{
+        return overflowCount.load();
+    }
+    
+    int getCoalescedCount() const{
+        return coalescedCount.load();
+    }
+    
+    int getCancelledCount() const{
+        return cancelledCount.load();
+    }
+    
+private:
+    
+    ofxThreadedVideoCommand commands[OFX_THREADED_VIDEO_QUEUE_SIZE];
+    std::atomic<int> states[OFX_THREADED_VIDEO_QUEUE_SIZE];
+    
+    // head and tail live on separate cache lines so producer and consumer don't false share
+    std::atomic<unsigned int> head;
+    char pad0[64 - sizeof(std::atomic<unsigned int>)];
+    std::atomic<unsigned int> tail;
+    char pad1[64 - sizeof(std::atomic<unsigned int>)];
+    
+    // producer only
+    unsigned int batchTail;
+    bool bBatching;
+    bool bBatchFailed;
+    
+    ofxThreadedVideoHandleTable * handles;
+
+    std::atomic<int> overflowCount;
+    std::atomic<int> coalescedCount;
+    std::atomic<int> cancelledCount;
+    
+};
+
+// the three lanes of an instance behind the same interface as a single
+// ring. pushing a load or stop first cancels pending transport commands:
+// they would otherwise run after it (stop; play) or act on the old movie.
+// loads are never cancelled as update() may already have started one.
+//
+// a batch goes entirely into the control lane so it can't be interleaved
+// with anything else. when it's published, older pending commands that
+// set the same values (same coalesce key) are cancelled in the other lanes
+// as they'd otherwise run after the batch and undo it
+class ofxThreadedVideoCommandLanes {
+    
+public:
+    
+    ofxThreadedVideoCommandLanes(){
+        claimedLane = 0;
+        bBatching = false;
+        nextSequence = 0;
+        controlSequence = 0;
+    }
+    
+    // producer side. nothing is folded into a command queued before the last
+    // control command, as that one runs first and sees the value it was given
+    bool coalesce(const ofxThreadedVideoCommand& c){
+        if(bBatching) return false;
+        return lanes[c.getLane()].coalesce(c, controlSequence);
+    }
+    
+    bool push(const ofxThreadedVideoCommand& c){
+        unsigned int sequence = nextSequence++;
+        if(c.getCommand() == VIDEO_COMMAND_LOAD ||
+           c.getCommand() == VIDEO_COMMAND_STOP ||
+           c.getCommand() == VIDEO_COMMAND_SET_PLAYLIST){
+            lanes[VIDEO_COMMAND_LANE_TRANSPORT].cancelPending();
+        }
+        if(bBatching){
+            batchKeys[c.getCoalesceKey()] = true;
+            controlSequence = sequence;
+            return lanes[VIDEO_COMMAND_LANE_CONTROL].push(c, sequence);
+        }
+        if(c.getLane() == VIDEO_COMMAND_LANE_CONTROL) controlSequence = sequence;
+        return lanes[c.getLane()].push(c, sequence);
+    }
+    
+    void beginBatch(){
+        memset(batchKeys, 0, sizeof(batchKeys));
+        lanes[VIDEO_COMMAND_LANE_CONTROL].beginBatch();
+        bBatching = true;
+    }
+    
+    bool endBatch(){
+        bBatching = false;
+        if(!lanes[VIDEO_COMMAND_LANE_CONTROL].endBatch()) return false;
+        batchKeys[VIDEO_COMMAND_NULL] = false;
+        lanes[VIDEO_COMMAND_LANE_TRANSPORT].cancelPending(batchKeys);
+        lanes[VIDEO_COMMAND_LANE_COSMETIC].cancelPending(batchKeys);
+        return true;
+    }
+    
+    bool isBatching() const{
+        return bBatching;
+    }
+    
+    void cancelPending(ofxThreadedVideoCommandLane lane){
+        lanes[lane].cancelPending();
+    }
+    
+    void setHandleTable(ofxThreadedVideoHandleTable * handles){
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) lanes[i].setHandleTable(handles);
+    }
+    
+    // consumer side, the claimed command's lane is remembered for front()/pop()
+    bool claimFront(ofxThreadedVideoCommand& c){
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++){
+            if(lanes[i].claimFront(c)){
+                claimedLane = i;
+                if(i == VIDEO_COMMAND_LANE_CONTROL) claimEarlierCommand(c);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void unclaimFront(){
+        lanes[claimedLane].unclaimFront();
+    }
+    
+    const ofxThreadedVideoCommand& front() const{
+        return lanes[claimedLane].front();
+    }
+    
+    void pop(){
+        lanes[claimedLane].pop();
+    }
+    
+    void clear(){
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) lanes[i].clear();
+    }
+    
+    // safe from either side
+    int size() const{
+        int total = 0;
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) total += lanes[i].size();
+        return total;
+    }
+    
+    // indexes run across the lanes in priority order
+    const ofxThreadedVideoCommand& at(int index) const{
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT - 1; i++){
+            int laneSize = lanes[i].size();
+            if(index < laneSize) return lanes[i].at(index);
+            index -= laneSize;
+        }
+        return lanes[VIDEO_COMMAND_LANE_COUNT - 1].at(index);
+    }
+    
+    int getOverflowCount() const{
+        int total = 0;
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) total += lanes[i].getOverflowCount();
+        return total;
+    }
+    
+    int getCoalescedCount() const{
+        int total = 0;
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) total += lanes[i].getCoalescedCount();
+        return total;
+    }
+    
+    int getCancelledCount() const{
+        int total = 0;
+        for(int i = 0; i < VIDEO_COMMAND_LANE_COUNT; i++) total += lanes[i].getCancelledCount();
+        return total;
+    }
+    
+private:
+    
+    // consumer side: swaps a claimed control command for the oldest of the
+    // other lanes' heads if any of those was queued first
+    void claimEarlierCommand(ofxThreadedVideoCommand& c){
+        for(int i = VIDEO_COMMAND_LANE_CONTROL + 1; i < VIDEO_COMMAND_LANE_COUNT; i++){
+            ofxThreadedVideoCommand earlier;
+            if(!lanes[i].claimFront(earlier)) continue;
+            if((int)(earlier.sequence - c.sequence) >= 0){
+                lanes[i].unclaimFront();
+                continue;
+            }
+            lanes[claimedLane].unclaimFront();
+            claimedLane = i;
+            c = earlier;
+        }
+    }
+    
+    ofxThreadedVideoCommandQueue lanes[VIDEO_COMMAND_LANE_COUNT];
+    int claimedLane;
+    
+    // producer only
+    bool bBatching;
+    bool batchKeys[VIDEO_COMMAND_SET_AUDIO_TRACK_TO_CHANNEL + 1];
+    unsigned int nextSequence;
+    unsigned int controlSequence;   // sequence of the last control (or batched) command
+    
+};
+
+// a seqlock: one writer at a time (serialised by the caller) publishes a
+// trivially copyable T, any number of readers take consistent copies
+// without locking. readers only retry if they overlap a store, which is a
+// copy of a few dozen bytes. the value is kept as relaxed atomic words so
+// the racing reads are well defined
+template<typename T>
+class ofxThreadedVideoSeqLock {
+    
+public:
+    
+    ofxThreadedVideoSeqLock(){
+        sequence = 0;
+        for(int i = 0; i < numWords; i++) words[i] = 0;
+    }
+    
+    void store(const T& value){
+        unsigned int buffer[numWords];
+        memcpy(buffer, &value, sizeof(T));
+        unsigned int seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(int i = 0; i < numWords; i++) words[i].store(buffer[i], std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+    
+    T load() const{
+        unsigned int buffer[numWords];
+        unsigned int seqBefore, seqAfter;
+        do{
+            seqBefore = sequence.load(std::memory_order_acquire);
+            for(int i = 0; i < numWords; i++) buffer[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seqAfter = sequence.load(std::memory_order_relaxed);
+        }while((seqBefore & 1) || seqBefore != seqAfter);
+        T value;
+        memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+    
+private:
+    
+    static const int numWords = (sizeof(T) + sizeof(unsigned int) - 1) / sizeof(unsigned int);
+    
+    std::atomic<unsigned int> sequence;
+    std::atomic<unsigned int> words[numWords];
+    
+};
+
+// everything the getters report, published together by publishState() so
+// getState() and the individual getters never take the instance mutex.
+// the movie name and path are strings so stay behind the mutex
+struct ofxThreadedVideoState {
+    
+    float width;
+    float height;
+    
+    float duration;
+    float speed;
+    float position;
+    
+    float volume;
+    float pan;
+    float fade;
+    
+    ofLoopType loopState;
+    ofPixelFormat pixelFormat;
+    
+    int frameCurrent;
+    int frameTotal;
+    
+    double frameRate;
+    
+    bool bLoaded;
+    bool bIsLoading;
+    bool bIsPlaying;
+    bool bIsPaused;
+    bool bIsMovieDone;
+    bool bIsTextureReady;
     
 };
 
 static ofxThreadedVideoCommand ofxThreadedVideoNullCommand;
 
-static ofMutex                          ofxThreadedVideoGlobalMutex;
-static bool                             ofxThreadedVideoGlobalCritical = false;
 static int                              ofxThreadedVideoGlobalInstanceID = 0;
 
-static int ofxThreadedVideoLoadOk;
-static int ofxThreadedVideoLoadFail;
+static std::atomic<int> ofxThreadedVideoLoadOk(0);
+static std::atomic<int> ofxThreadedVideoLoadFail(0);
 
-class ofxThreadedVideo : public ofThread {
+class ofxThreadedVideo : public ofThread, public ofxThreadedVideoTask {
 
 public:
 
     ofxThreadedVideo();
     ~ofxThreadedVideo();
     
+    // by default every instance runs its own worker thread; call this before
+    // creating instances to have them share a fixed pool instead (numThreads
+    // = 0 sizes it to the core count). each instance's commands still run in
+    // order as only one pool thread works on a given instance at a time
+    static void setUseWorkerPool(bool b, int numThreads = 0);
+    static bool getUseWorkerPool();
+    
     template <typename T>
     void setPlayer(){
         video[0].setPlayer(ofPtr<T>(new T));
         video[1].setPlayer(ofPtr<T>(new T));
+        // the preload cache opens players of its own
+        playerFactory = [](){ return ofPtr<ofBaseVideoPlayer>(new T); };
+        clearPreloadCache();
     }
 
     ofPtr<ofBaseVideoPlayer> getPlayer();
 
-    void load(const string& path);
-    void loadMovie(const string& path);
+    ofxThreadedVideoHandle load(const string& path);
+    ofxThreadedVideoHandle loadMovie(const string& path);
+    
+    // preload cache: keep up to numPlayers movies opened and prerolled in
+    // their own players, so a later load() of the same path just swaps the
+    // player in instead of opening and parsing the file. least recently
+    // preloaded are closed first once there are more than numPlayers or
+    // their pixels take more than maxBytes (0 = no limit). 0 = off (default)
+    void setPreloadCache(int numPlayers, size_t maxBytes = 0);
+    int getPreloadCacheSize();
+    
+    // opens path on the worker after any pending loads, stops and transport
+    // commands, so queue it well before the load() that should hit it
+    ofxThreadedVideoHandle preload(const string& path);
+    bool isPreloaded(const string& path);
+    int getPreloadHits();
+    int getPreloadMisses();
+    
+    // gapless playlist: loads and plays the first item, then opens and
+    // prerolls each next item in the idle player while the current one
+    // plays and starts it on the update() the current one finishes, so
+    // there's no black or repeated frame in between. items play once each
+    // (their loop state is forced to OF_LOOP_NONE), bLoop goes round again
+    // after the last. any other load() or stop() ends the playlist.
+    // with decode ahead on the switch happens on the worker, inside the ring
+    void setPlaylist(const vector<string>& paths, bool bLoop = true);
+    void clearPlaylist();
+    int getPlaylistIndex(); // -1 when there's no playlist
+    int getPlaylistSize();
+    
     void setPixelFormat(ofPixelFormat pixelFormat);
     ofPixelFormat getPixelFormat();
     void closeMovie();
@@ -374,12 +1219,17 @@ public:
     bool isFrameNew();
     unsigned char * getPixels();
     ofPixelsRef	getPixelsRef();
+    
+    // the current frame as RGB, RGBA or BGRA for cpu side consumers; YUY2,
+    // I420 and NV12 frames are converted with the internal shader's
+    // constants, anything else is returned as is (same as getPixelsRef)
+    ofPixelsRef getConvertedPixelsRef(ofPixelFormat pixelFormat = OF_PIXELS_RGB);
     float getPosition();
     float getSpeed();
     float getDuration();
     bool getIsMovieDone();
 
-    void setPosition(float pct);
+    ofxThreadedVideoHandle setPosition(float pct);
     void setVolume(float volume);
 
 #ifdef USE_QUICKTIME_7
@@ -391,7 +1241,7 @@ public:
     void setLoopState(ofLoopType state);
     int getLoopState();
     void setSpeed(float speed);
-    void setFrame(int frame);
+    ofxThreadedVideoHandle setFrame(int frame);
 
 	void setUseBlackStop(bool b);
     void setUseTexture(bool bUse);
@@ -450,24 +1300,200 @@ public:
     
     void setVerbose(bool b);
     
+    // a consistent copy of the playback state in one call, without locking
+    ofxThreadedVideoState getState();
+    
     void flush();
+    
+    // commands issued between beginBatch() and endBatch() are queued as
+    // one group, eg., a cue of load + setLoopState + setVolume + setFade +
+    // play. the group is published in one go, nothing else is interleaved
+    // with it and no frame is shown until all of it has been applied.
+    // if the queue can't fit the whole group it's dropped (and logged)
+    void beginBatch();
+    void endBatch();
     void finish();
     
     int getQueueSize();
+    int getQueueOverflow();
+    
+    // number of setFrame/setPosition/setVolume/setPan/setSpeed/setLoopState
+    // calls folded into an already pending command of the same kind
+    int getQueueCoalesced();
+    
+    // number of pending commands dropped because a later load or stop
+    // made them obsolete
+    int getQueueCancelled();
+    
+    // enqueue -> execute latency in microseconds over the last
+    // OFX_THREADED_VIDEO_LATENCY_SAMPLES commands, eg., 0.5 = p50, 0.99 = p99
+    float getCommandLatency(float percentile);
+    
+    // decode ahead: the worker pumps the backend and copies each new frame
+    // into a ring of numFrames pooled buffers; update() then only presents
+    // (uploads) whichever frame is due. frames are presented numFrames frame
+    // durations after they're decoded, so a worker that stalls for less than
+    // that doesn't cause a visible hitch - at the cost of showing video that
+    // much later than the backend's own (audio) clock. 0 = off (default).
+    // seeks and black stops still go straight to the backend's pixels
+    void setDecodeAhead(int numFrames);
+    int getDecodeAhead();
+    
+    int getDecodeAheadOccupancy();  // frames currently waiting in the ring
+    int getDecodeAheadUnderruns();  // times update() found nothing due when a frame was expected
+    int getDecodeAheadDropped();    // frames dropped because update() didn't keep up
+    
+    // run every backend call (commands, update()/MoviesTask, pixel copies)
+    // on the worker or pool strand; update() then only uploads the newest
+    // prepared frame to the texture, which has to stay on the GL thread.
+    // decode ahead of 0 presents frames as soon as they're ready
+    void setBackendOnWorker(bool b);
+    bool getBackendOnWorker();
+    
+    // convert YUY2, I420 or NV12 frames to RGB, RGBA or BGRA on their way
+    // into the decode ahead ring (so on the worker, with setDecodeAhead() or
+    // setBackendOnWorker()), split across ofxThreadedVideoConvert's threads
+    // for big frames. update() then just uploads the converted frame and the
+    // internal shaders are skipped. OF_PIXELS_UNKNOWN = off (default)
+    void setConvertPixelFormat(ofPixelFormat pixelFormat);
+    ofPixelFormat getConvertPixelFormat();
+    
+    // largest size frames are uploaded at, eg., for thumbnail mosaics:
+    // they're scaled down to fit inside width x height keeping their aspect
+    // (0 = no limit on that side, 0 x 0 = full size, the default). backends
+    // that can decode to size (QuickTime, image sequences) do so from the
+    // next load; anything else is box filtered on the worker on its way into
+    // the decode ahead ring, which is used for this even with a decode ahead
+    // of 0. getWidth()/getHeight() still report the movie's own size
+    void setOutputSize(int width, int height);
+    int getOutputWidth();
+    int getOutputHeight();
     int getLoadOk();
     int getLoadFail();
     
+    // instances execute commands concurrently; if a backend can't cope with
+    // several movies being opened/closed at once, cap how many instances may
+    // be inside load()/close() at the same time (0 = unlimited, the default)
+    static void setGlobalBackendLimit(int maxConcurrent);
+    static int getGlobalBackendLimit();
+    
 protected:
 
     void threadedFunction();
-
-    bool getGlobalSafe();
-    void setGlobalSafe();
-    void setGlobalUnSafe();
+    bool threadedUpdate(bool& bContended, int& tickMillis);
+    
+    void runTask();
+    void wakeTask();
+    void scheduleStrand();
+    
+    static bool bUseWorkerPool;
+    static int workerPoolThreads;
+    
+    bool bUsePool;
+    atomic<int> strandRequests;
+    atomic<bool> bStrandTimer;
+    atomic<bool> bClosing;
     
-    void pushCommand(ofxThreadedVideoCommand& c, bool back = true);
+    void lockBackend();
+    void unlockBackend();
+    
+    static ofMutex backendMutex;
+    static condition_variable backendCondition;
+    static int backendLimit;
+    static int backendActive;
+    
+    void publishState();
+    ofxThreadedVideoSeqLock<ofxThreadedVideoState> publishedState;
+    
+    ofxThreadedVideoHandle pushCommand(ofxThreadedVideoCommand& c);
+    ofxThreadedVideoHandle failCommand(ofxThreadedVideoCommand& c);
+    ofPtr<ofxThreadedVideoHandleTable> handles;
     ofxThreadedVideoCommand getCommand();
-    void popCommand();
+    bool executeUpdateCommand(const ofxThreadedVideoCommand& c, int videoID, bool bCanStop, bool& bSignalWorker, unsigned long long timeStarted);
+    void popCommand(unsigned long long timeStarted, bool bFailed = false);
+    void releaseCommand();
+    
+    bool bCommandClaimed;
+    int groupRemaining;
+    
+    struct PreloadedPlayer {
+        string path;
+        ofPtr<ofBaseVideoPlayer> player;
+        ofPixelFormat pixelFormat;
+        int outputWidth;        // setOutputSize() when it was opened
+        int outputHeight;
+        size_t numBytes;
+    };
+    
+    // the cache list is guarded by the mutex, players are opened and
+    // closed outside it (under lockBackend) by whoever took them out
+    void preloadPlayer(const string& path);
+    bool takePreloadedPlayer(const string& path, ofPtr<ofBaseVideoPlayer>& player);
+    void trimPreloadCache(list<PreloadedPlayer>& evicted);
+    void releasePreloadedPlayers(list<PreloadedPlayer>& evicted);
+    void clearPreloadCache();
+    
+    struct PendingPlaylist {
+        vector<string> paths;
+        bool bLoop;
+    };
+    
+    // playlist state is guarded by the mutex
+    void endPlaylist();
+    void prerollPlaylistItem();
+    bool switchPlaylistItem(int& videoID);
+    
+    map<int, PendingPlaylist> pendingPlaylists; // waiting for their SET_PLAYLIST command
+    int nextPlaylistID;
+    vector<string> playlist;
+    int playlistIndex;
+    int playlistGeneration;     // bumped whenever the playlist starts or ends
+    int prerollID;              // idle slot holding the next item, -1 = not ready
+    int prerollIndex;
+    bool bPlaylistLoop;
+    bool bPlaylistStarting;     // its first load hasn't been prepared yet
+    
+    function<ofPtr<ofBaseVideoPlayer>()> playerFactory;
+    list<PreloadedPlayer> preloadCache; // most recently preloaded first
+    int preloadCacheSlots;
+    size_t preloadCacheBytes;
+    atomic<int> preloadHits;
+    atomic<int> preloadMisses;
+    
+    // decode ahead ring, only touched by whoever holds the critical section
+    void decodeAhead(int videoID, bool bPresentForced = false, bool bPrerolled = false);
+    void clearDecodedFrames();
+    void releaseFrameBuffers();
+    ofxThreadedVideoFrame * presentDecodedFrame();
+    float getFrameDurationMillis();
+    
+    atomic<int> decodeAheadFrames;
+    atomic<int> decodeAheadOccupancy;
+    atomic<int> decodeAheadUnderruns;
+    atomic<int> decodeAheadDropped;
+    atomic<bool> bBackendOnWorker;
+    atomic<int> convertPixelFormat;
+    atomic<int> outputWidth;
+    atomic<int> outputHeight;
+    void setPlayerOutputSize(ofPtr<ofBaseVideoPlayer> player, int width, int height);
+    ofPixels scaledPixels;      // worker side, frames scaled before they go in the ring
+    ofPixels uploadPixels;      // update() side, frames that didn't come through the ring
+    vector<ofPixels*> frameBuffers;
+    vector<ofPixels*> freeFrameBuffers;
+    deque<ofxThreadedVideoFrame> decodedFrames;
+    ofxThreadedVideoFrame presentedFrame;
+    unsigned long long timeLastPresented;
+    bool bUnderrun;
+    
+    void signalWorker();
+    void waitForWork(bool bContended, int tickMillis);
+    
+    ofMutex wakeMutex;
+    condition_variable wakeCondition;
+    bool bWakeWorker;
+    
+    float commandLatency[OFX_THREADED_VIDEO_LATENCY_SAMPLES];
+    int commandLatencyCount;
 
     static const int VIDEO_NONE = -1;
     static const int VIDEO_FLIP = 0;
@@ -477,23 +1503,35 @@ protected:
 
     //--------------------------------------------------------------
     
-    deque<ofxThreadedVideoCommand>   ofxThreadedVideoCommands;
+    ofxThreadedVideoCommandLanes ofxThreadedVideoCommands;
     
     bool bLoaded;
     bool bCriticalSection;
+    thread::id criticalSectionThread;   // whoever set bCriticalSection
+    condition_variable criticalSectionCondition;   // notified (under lock()) when it's cleared
+    bool bFlushPending;
     int currentVideoID;
     
     ofVideoPlayer video[2];
     ofPixels * pixels;
+    ofPixels convertedPixels;
     ofTexture drawTexture;
     
     ofFbo fboYUY2;
     ofShader shader;
+    
+    // I420/NV12: drawTexture holds luma, chroma goes in here
+    void loadPlaneTextures(const unsigned char * pixels, int frameWidth, int frameHeight);
+    ofTexture chromaTextures[2];
+    ofShader planarShader;
+    bool bPlanarTexture;
     bool bUseInternalShader;
     
     int textureInternalType;
     int textureFormatType;
     int texturePixelType;
+    ofPixelFormat texturePixelFormat;
+    bool bTextureConverted;
     
 	bool bUseBlackStop;
 	bool bForceBlack;
@@ -574,5 +1612,3 @@ inline ostream& operator<<(ostream& os, const ofxThreadedVideoEvent &e){
 };
 
 #endif
-
-#endif
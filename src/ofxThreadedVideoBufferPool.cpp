@@ -0,0 +1,247 @@
+/*
+ * ofxThreadedVideoBufferPool.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#include "ofxThreadedVideoBufferPool.h"
+
+#ifdef TARGET_WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+//--------------------------------------------------------------
+ofxThreadedVideoBufferPool& ofxThreadedVideoBufferPool::getPool(){
+    static ofxThreadedVideoBufferPool pool;
+    return pool;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoBufferPool::ofxThreadedVideoBufferPool(){
+    maxIdleBytes = 256 * 1024 * 1024;
+    bytesInUse = 0;
+    bytesIdle = 0;
+    highWaterBytes = 0;
+    highWaterBuffers = 0;
+    numAllocations = 0;
+    numReuses = 0;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoBufferPool::~ofxThreadedVideoBufferPool(){
+    trim();
+    // anything still in use belongs to players that outlived us, leave it be
+}
+
+//--------------------------------------------------------------
+unsigned char * ofxThreadedVideoBufferPool::acquire(int width, int height, ofPixelFormat pixelFormat, size_t numBytes){
+
+    Key key;
+    key.width = width;
+    key.height = height;
+    key.pixelFormat = pixelFormat;
+    key.numBytes = numBytes;
+
+    ofScopedLock lock(mutex);
+
+    unsigned char * buffer = NULL;
+
+    map<Key, vector<Idle> >::iterator it = idle.find(key);
+    if(it != idle.end() && it->second.size() > 0){
+        // most recently released first, it's the most likely to still be in cache
+        buffer = it->second.back().buffer;
+        it->second.pop_back();
+        if(it->second.size() == 0) idle.erase(it);
+        bytesIdle -= numBytes;
+        numReuses++;
+    }else{
+        buffer = allocateAligned(numBytes);
+        if(buffer == NULL){
+            ofLogError() << "ofxThreadedVideoBufferPool could not allocate " << numBytes << " bytes for " << width << "x" << height;
+            return NULL;
+        }
+        numAllocations++;
+    }
+
+    inUse[buffer] = key;
+    bytesInUse += numBytes;
+
+    highWaterBytes = MAX(highWaterBytes, bytesInUse + bytesIdle);
+    highWaterBuffers = MAX(highWaterBuffers, (int)inUse.size());
+
+    return buffer;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::release(unsigned char * buffer){
+
+    if(buffer == NULL) return;
+
+    ofScopedLock lock(mutex);
+
+    map<unsigned char*, Key>::iterator it = inUse.find(buffer);
+    if(it == inUse.end()){
+        ofLogError() << "ofxThreadedVideoBufferPool asked to release a buffer it doesn't own";
+        return;
+    }
+
+    Key key = it->second;
+    inUse.erase(it);
+    bytesInUse -= key.numBytes;
+
+    if(key.numBytes > maxIdleBytes){
+        freeAligned(buffer);
+        return;
+    }
+
+    evictIdle(key.numBytes);
+
+    Idle entry;
+    entry.buffer = buffer;
+    entry.timeReleased = ofGetElapsedTimeMicros();
+    idle[key].push_back(entry);
+    bytesIdle += key.numBytes;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoBufferPool::acquire(ofPixels& pixels, int width, int height, ofPixelFormat pixelFormat){
+    unsigned char * buffer = acquire(width, height, pixelFormat, ofPixels::bytesFromPixelFormat(width, height, pixelFormat));
+    if(buffer == NULL) return false;
+    pixels.setFromExternalPixels(buffer, width, height, pixelFormat);
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::release(ofPixels& pixels){
+    unsigned char * buffer = pixels.getPixels();
+    pixels.clear();
+    release(buffer);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::trim(){
+    ofScopedLock lock(mutex);
+    for(map<Key, vector<Idle> >::iterator it = idle.begin(); it != idle.end(); ++it){
+        for(int i = 0; i < it->second.size(); i++) freeAligned(it->second[i].buffer);
+    }
+    idle.clear();
+    bytesIdle = 0;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::setMaxIdleBytes(size_t maxBytes){
+    ofScopedLock lock(mutex);
+    maxIdleBytes = maxBytes;
+    evictIdle(0);
+}
+
+//--------------------------------------------------------------
+size_t ofxThreadedVideoBufferPool::getMaxIdleBytes(){
+    ofScopedLock lock(mutex);
+    return maxIdleBytes;
+}
+
+//--------------------------------------------------------------
+size_t ofxThreadedVideoBufferPool::getBytesInUse(){
+    ofScopedLock lock(mutex);
+    return bytesInUse;
+}
+
+//--------------------------------------------------------------
+size_t ofxThreadedVideoBufferPool::getBytesIdle(){
+    ofScopedLock lock(mutex);
+    return bytesIdle;
+}
+
+//--------------------------------------------------------------
+size_t ofxThreadedVideoBufferPool::getHighWaterBytes(){
+    ofScopedLock lock(mutex);
+    return highWaterBytes;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoBufferPool::getHighWaterBuffers(){
+    ofScopedLock lock(mutex);
+    return highWaterBuffers;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoBufferPool::getNumAllocations(){
+    ofScopedLock lock(mutex);
+    return numAllocations;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoBufferPool::getNumReuses(){
+    ofScopedLock lock(mutex);
+    return numReuses;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::evictIdle(size_t numBytes){
+
+    // callers hold the mutex; make room for numBytes more by freeing the
+    // idle buffers that have been sitting there longest
+    while(bytesIdle > 0 && bytesIdle + numBytes > maxIdleBytes){
+
+        map<Key, vector<Idle> >::iterator oldest = idle.end();
+        for(map<Key, vector<Idle> >::iterator it = idle.begin(); it != idle.end(); ++it){
+            if(oldest == idle.end() || it->second.front().timeReleased < oldest->second.front().timeReleased) oldest = it;
+        }
+
+        freeAligned(oldest->second.front().buffer);
+        oldest->second.erase(oldest->second.begin());
+        bytesIdle -= oldest->first.numBytes;
+        if(oldest->second.size() == 0) idle.erase(oldest);
+
+    }
+
+}
+
+//--------------------------------------------------------------
+unsigned char * ofxThreadedVideoBufferPool::allocateAligned(size_t numBytes){
+#ifdef TARGET_WIN32
+    return (unsigned char *)_aligned_malloc(numBytes, OFX_THREADED_VIDEO_BUFFER_ALIGNMENT);
+#else
+    void * buffer = NULL;
+    if(posix_memalign(&buffer, OFX_THREADED_VIDEO_BUFFER_ALIGNMENT, numBytes) != 0) return NULL;
+    return (unsigned char *)buffer;
+#endif
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoBufferPool::freeAligned(unsigned char * buffer){
+#ifdef TARGET_WIN32
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+}
@@ -0,0 +1,126 @@
+/*
+ * ofxThreadedVideoBufferPool.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#ifndef __H_OFXTHREADEDVIDEOBUFFERPOOL
+#define __H_OFXTHREADEDVIDEOBUFFERPOOL
+
+#include <map>
+
+#include "ofMain.h"
+
+// buffers are aligned for SIMD loads/stores
+#define OFX_THREADED_VIDEO_BUFFER_ALIGNMENT 32
+
+// process wide pool of aligned frame buffers, shared by every player and
+// ofxThreadedVideo instance. released buffers are kept on a free list keyed
+// by (width, height, format) and handed straight back out to the next load
+// of the same size, so reloading clips doesn't keep fragmenting the heap
+// (which matters a lot in the 32 bit address space QuickTime is stuck in).
+//
+// idle buffers are kept up to setMaxIdleBytes(), oldest sizes freed first
+class ofxThreadedVideoBufferPool {
+
+public:
+
+    ofxThreadedVideoBufferPool();
+    ~ofxThreadedVideoBufferPool();
+
+    static ofxThreadedVideoBufferPool& getPool();
+
+    // numBytes is what the caller will actually touch, buffers of the
+    // same key but a different size are never shared
+    unsigned char * acquire(int width, int height, ofPixelFormat pixelFormat, size_t numBytes);
+    void release(unsigned char * buffer);
+
+    // acquire a buffer and point pixels at it; pass the pixels back to
+    // release(ofPixels&) rather than clearing them
+    bool acquire(ofPixels& pixels, int width, int height, ofPixelFormat pixelFormat);
+    void release(ofPixels& pixels);
+
+    // free every idle buffer
+    void trim();
+
+    void setMaxIdleBytes(size_t maxBytes);
+    size_t getMaxIdleBytes();
+
+    size_t getBytesInUse();
+    size_t getBytesIdle();
+    size_t getHighWaterBytes();     // most bytes ever allocated at once (in use + idle)
+    int getHighWaterBuffers();      // most buffers ever in use at once
+    int getNumAllocations();        // buffers actually allocated from the heap
+    int getNumReuses();             // acquires served from the free list
+
+protected:
+
+    struct Key {
+        int width;
+        int height;
+        int pixelFormat;
+        size_t numBytes;
+        bool operator<(const Key& other) const {
+            if(width != other.width) return width < other.width;
+            if(height != other.height) return height < other.height;
+            if(pixelFormat != other.pixelFormat) return pixelFormat < other.pixelFormat;
+            return numBytes < other.numBytes;
+        }
+    };
+
+    struct Idle {
+        unsigned char * buffer;
+        unsigned long long timeReleased;
+    };
+
+    void evictIdle(size_t numBytes);
+
+    static unsigned char * allocateAligned(size_t numBytes);
+    static void freeAligned(unsigned char * buffer);
+
+    ofMutex mutex;
+    map<Key, vector<Idle> > idle;
+    map<unsigned char*, Key> inUse;
+
+    size_t maxIdleBytes;
+    size_t bytesInUse;
+    size_t bytesIdle;
+    size_t highWaterBytes;
+    int highWaterBuffers;
+    int numAllocations;
+    int numReuses;
+
+private:
+
+    // block copy ctor and assignment operator
+    ofxThreadedVideoBufferPool(const ofxThreadedVideoBufferPool& other);
+    ofxThreadedVideoBufferPool& operator=(const ofxThreadedVideoBufferPool&);
+
+};
+
+#endif
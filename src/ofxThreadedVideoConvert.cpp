@@ -0,0 +1,1135 @@
+/*
+ * ofxThreadedVideoConvert.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#include "ofxThreadedVideoConvert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OFX_THREADED_VIDEO_CONVERT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define OFX_THREADED_VIDEO_TARGET_SSE2
+#define OFX_THREADED_VIDEO_TARGET_AVX2
+#else
+#define OFX_THREADED_VIDEO_TARGET_SSE2 __attribute__((target("sse2")))
+#define OFX_THREADED_VIDEO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define OFX_THREADED_VIDEO_CONVERT_X86 0
+#endif
+
+#define OFX_THREADED_VIDEO_CONVERT_BITS 13
+
+// the shader's math with everything scaled to 8 bit and then by 1 << 13:
+//
+//   y = 1.164383561643836 * (Y - 15.9375)    (0.0625 * 255)
+//   u = U - 127.5, v = V - 127.5             (0.5 * 255)
+//
+// the constant parts of each channel (and the rounding) are folded into a
+// single offset so each channel is just cy * Y + cu * U + cv * V + offset
+struct ofxThreadedVideoConvertCoefficients {
+
+    ofxThreadedVideoConvertCoefficients(double kb, double kr){
+
+        const double c = 2.276785714285714;
+        const double scale = 1 << OFX_THREADED_VIDEO_CONVERT_BITS;
+
+        y  = round(1.164383561643836 * scale);
+        ru = 0;
+        rv = round(c * (1.0 - kr) * scale);
+        gu = round(-c * (1.0 - kb) * (kb / (1.0 - kb - kr)) * scale);
+        gv = round(-c * (1.0 - kr) * (kr / (1.0 - kb - kr)) * scale);
+        bu = round(c * (1.0 - kb) * scale);
+        bv = 0;
+
+        rOffset = getOffset(ru, rv);
+        gOffset = getOffset(gu, gv);
+        bOffset = getOffset(bu, bv);
+
+    }
+
+    int getOffset(int cu, int cv){
+        return (int)floor(-(y * 15.9375 + cu * 127.5 + cv * 127.5) + 0.5) + (1 << (OFX_THREADED_VIDEO_CONVERT_BITS - 1));
+    }
+
+    int y;
+    int ru, rv;
+    int gu, gv;
+    int bu, bv;
+    int rOffset, gOffset, bOffset;
+
+};
+
+//--------------------------------------------------------------
+static const ofxThreadedVideoConvertCoefficients& ofxThreadedVideoConvertGetCoefficients(int conversionType){
+    static const ofxThreadedVideoConvertCoefficients coefficients601(0.114, 0.299);
+    static const ofxThreadedVideoConvertCoefficients coefficients709(0.0722, 0.2126);
+    return conversionType == 709 ? coefficients709 : coefficients601;
+}
+
+//--------------------------------------------------------------
+static inline unsigned char ofxThreadedVideoConvertClamp(int v){
+    v >>= OFX_THREADED_VIDEO_CONVERT_BITS;
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+// output byte offsets of r, g, b and the pixel size for each format
+struct ofxThreadedVideoConvertLayout {
+    int r, g, b, a, bytesPerPixel;
+};
+
+//--------------------------------------------------------------
+static ofxThreadedVideoConvertLayout ofxThreadedVideoConvertGetLayout(ofPixelFormat pixelFormat){
+    ofxThreadedVideoConvertLayout layout;
+    switch(pixelFormat){
+        case OF_PIXELS_BGRA:
+            layout.r = 2; layout.g = 1; layout.b = 0; layout.a = 3; layout.bytesPerPixel = 4;
+            break;
+        case OF_PIXELS_RGBA:
+            layout.r = 0; layout.g = 1; layout.b = 2; layout.a = 3; layout.bytesPerPixel = 4;
+            break;
+        default:
+            layout.r = 0; layout.g = 1; layout.b = 2; layout.a = -1; layout.bytesPerPixel = 3;
+            break;
+    }
+    return layout;
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoConvertRowScalar(const unsigned char * src, unsigned char * dst, int x, int width,
+                                             const ofxThreadedVideoConvertLayout& layout, const ofxThreadedVideoConvertCoefficients& k){
+
+    // x is always even - the vector kernels hand over on a pixel pair
+    const unsigned char * in = src + x * 2;
+    unsigned char * out = dst + x * layout.bytesPerPixel;
+
+    for(; x < width; x += 2, in += 4){
+
+        // an odd width leaves the last pixel without its partner (or a Cr)
+        int count = x + 1 < width ? 2 : 1;
+
+        int u = in[0];
+        int v = count == 2 ? in[2] : 128;
+
+        int r = k.ru * u + k.rv * v + k.rOffset;
+        int g = k.gu * u + k.gv * v + k.gOffset;
+        int b = k.bu * u + k.bv * v + k.bOffset;
+
+        for(int i = 0; i < count; i++){
+            int y = k.y * in[1 + i * 2];
+            out[layout.r] = ofxThreadedVideoConvertClamp(y + r);
+            out[layout.g] = ofxThreadedVideoConvertClamp(y + g);
+            out[layout.b] = ofxThreadedVideoConvertClamp(y + b);
+            if(layout.a != -1) out[layout.a] = 255;
+            out += layout.bytesPerPixel;
+        }
+
+    }
+
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoSwizzleRowScalar(const unsigned char * src, unsigned char * dst, int x, int width, ofxThreadedVideoSwizzleType type){
+
+    const unsigned char * in = src + x * 4;
+
+    switch(type){
+        case SWIZZLE_ARGB_TO_RGB:
+        case SWIZZLE_RGBA_TO_RGB:{
+            int first = type == SWIZZLE_ARGB_TO_RGB ? 1 : 0;
+            unsigned char * out = dst + x * 3;
+            for(; x < width; x++, in += 4, out += 3){
+                memcpy(out, in + first, 3);
+            }
+            break;
+        }
+        case SWIZZLE_BGRA_TO_RGBA:{
+            unsigned char * out = dst + x * 4;
+            for(; x < width; x++, in += 4, out += 4){
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+                out[3] = in[3];
+            }
+            break;
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoScaleAccumulateScalar(const unsigned char * src, unsigned short * sums, int x, int numBytes, bool bFirst){
+    if(bFirst){
+        for(; x < numBytes; x++) sums[x] = src[x];
+    }else{
+        for(; x < numBytes; x++) sums[x] += src[x];
+    }
+}
+
+//--------------------------------------------------------------
+template<int numChannels, typename Sum, typename Total>
+static void ofxThreadedVideoScaleRowScalar(const Sum * sums, unsigned char * dst, int width,
+                                           const int * columns, const unsigned long long * recips){
+
+    // each output pixel averages the column sums it covers; recips are
+    // (1 << 32) / area rounded up, so the divide is a multiply and a shift
+    // and still rounds exactly for anything up to 8 bits a sample
+    for(int x = 0; x < width; x++, dst += numChannels){
+        const Sum * in = sums + columns[x] * numChannels;
+        const Sum * end = sums + columns[x + 1] * numChannels;
+        Total total[numChannels];
+        for(int c = 0; c < numChannels; c++) total[c] = 0;
+        for(; in < end; in += numChannels){
+            for(int c = 0; c < numChannels; c++) total[c] += in[c];
+        }
+        for(int c = 0; c < numChannels; c++) dst[c] = (unsigned char)((total[c] * recips[x] + (1ULL << 31)) >> 32);
+    }
+
+}
+
+//--------------------------------------------------------------
+template<typename Sum, typename Total>
+static void ofxThreadedVideoScaleRow(const Sum * sums, unsigned char * dst, int width, int numChannels,
+                                     const int * columns, const unsigned long long * recips){
+    switch(numChannels){
+        case 1:
+            ofxThreadedVideoScaleRowScalar<1, Sum, Total>(sums, dst, width, columns, recips);
+            break;
+        case 2:
+            ofxThreadedVideoScaleRowScalar<2, Sum, Total>(sums, dst, width, columns, recips);
+            break;
+        case 3:
+            ofxThreadedVideoScaleRowScalar<3, Sum, Total>(sums, dst, width, columns, recips);
+            break;
+        default:
+            ofxThreadedVideoScaleRowScalar<4, Sum, Total>(sums, dst, width, columns, recips);
+            break;
+    }
+}
+
+#if OFX_THREADED_VIDEO_CONVERT_X86
+
+//--------------------------------------------------------------
+static inline OFX_THREADED_VIDEO_TARGET_SSE2 __m128i ofxThreadedVideoConvertChannelSSE2(__m128i uv, __m128i yLo, __m128i yHi, int cu, int cv, int offset){
+    __m128i c = _mm_add_epi32(_mm_madd_epi16(uv, _mm_set_epi16(cv, cu, cv, cu, cv, cu, cv, cu)), _mm_set1_epi32(offset));
+    // each chroma sum covers a pixel pair
+    __m128i lo = _mm_srai_epi32(_mm_add_epi32(yLo, _mm_unpacklo_epi32(c, c)), OFX_THREADED_VIDEO_CONVERT_BITS);
+    __m128i hi = _mm_srai_epi32(_mm_add_epi32(yHi, _mm_unpackhi_epi32(c, c)), OFX_THREADED_VIDEO_CONVERT_BITS);
+    return _mm_packs_epi32(lo, hi);
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_SSE2 int ofxThreadedVideoConvertRowSSE2(const unsigned char * src, unsigned char * dst, int width,
+                                                                      const ofxThreadedVideoConvertLayout& layout, const ofxThreadedVideoConvertCoefficients& k){
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    const __m128i alpha = _mm_set1_epi16(255);
+    const __m128i cy = _mm_set1_epi32(k.y);
+    const bool bSwapRB = layout.r == 2;
+
+    // rgb writes a byte past the 8 pixels, so keep a pixel spare
+    int lastX = layout.bytesPerPixel == 3 ? width - 9 : width - 8;
+
+    int x = 0;
+    for(; x <= lastX; x += 8){
+
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + x * 2));
+        __m128i y = _mm_srli_epi16(v, 8);
+        __m128i uv = _mm_and_si128(v, mask);
+
+        __m128i yLo = _mm_madd_epi16(_mm_unpacklo_epi16(y, zero), cy);
+        __m128i yHi = _mm_madd_epi16(_mm_unpackhi_epi16(y, zero), cy);
+
+        __m128i r = ofxThreadedVideoConvertChannelSSE2(uv, yLo, yHi, k.ru, k.rv, k.rOffset);
+        __m128i g = ofxThreadedVideoConvertChannelSSE2(uv, yLo, yHi, k.gu, k.gv, k.gOffset);
+        __m128i b = ofxThreadedVideoConvertChannelSSE2(uv, yLo, yHi, k.bu, k.bv, k.bOffset);
+
+        __m128i rb = bSwapRB ? _mm_packus_epi16(b, r) : _mm_packus_epi16(r, b);
+        __m128i ga = _mm_packus_epi16(g, alpha);
+        __m128i rg = _mm_unpacklo_epi8(rb, ga);
+        __m128i ba = _mm_unpackhi_epi8(rb, ga);
+        __m128i p0 = _mm_unpacklo_epi16(rg, ba);
+        __m128i p1 = _mm_unpackhi_epi16(rg, ba);
+
+        if(layout.bytesPerPixel == 4){
+            _mm_storeu_si128((__m128i*)(dst + x * 4), p0);
+            _mm_storeu_si128((__m128i*)(dst + x * 4 + 16), p1);
+        }else{
+            // no byte shuffle in SSE2, so drop alpha with overlapping 4 byte writes
+            unsigned char * out = dst + x * 3;
+            for(int i = 0; i < 4; i++){
+                int p = _mm_cvtsi128_si32(p0);
+                memcpy(out, &p, 4);
+                out += 3;
+                p0 = _mm_srli_si128(p0, 4);
+            }
+            for(int i = 0; i < 4; i++){
+                int p = _mm_cvtsi128_si32(p1);
+                memcpy(out, &p, 4);
+                out += 3;
+                p1 = _mm_srli_si128(p1, 4);
+            }
+        }
+
+    }
+
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static inline OFX_THREADED_VIDEO_TARGET_AVX2 __m256i ofxThreadedVideoConvertChannelAVX2(__m256i uv, __m256i yLo, __m256i yHi, int cu, int cv, int offset){
+    __m256i c = _mm256_add_epi32(_mm256_madd_epi16(uv, _mm256_set1_epi32((int)(((unsigned int)cv << 16) | ((unsigned int)cu & 0xFFFF)))), _mm256_set1_epi32(offset));
+    __m256i lo = _mm256_srai_epi32(_mm256_add_epi32(yLo, _mm256_unpacklo_epi32(c, c)), OFX_THREADED_VIDEO_CONVERT_BITS);
+    __m256i hi = _mm256_srai_epi32(_mm256_add_epi32(yHi, _mm256_unpackhi_epi32(c, c)), OFX_THREADED_VIDEO_CONVERT_BITS);
+    return _mm256_packs_epi32(lo, hi);
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_AVX2 int ofxThreadedVideoConvertRowAVX2(const unsigned char * src, unsigned char * dst, int width,
+                                                                      const ofxThreadedVideoConvertLayout& layout, const ofxThreadedVideoConvertCoefficients& k){
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    const __m256i alpha = _mm256_set1_epi16(255);
+    const __m256i cy = _mm256_set1_epi32(k.y);
+    const __m256i dropAlpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                               0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const bool bSwapRB = layout.r == 2;
+
+    // rgb stores run 4 bytes past the 16 pixels, so keep two pixels spare
+    int lastX = layout.bytesPerPixel == 3 ? width - 18 : width - 16;
+
+    int x = 0;
+    for(; x <= lastX; x += 16){
+
+        // every op below stays within its 128 bit lane, so lane 0 works
+        // on pixels 0-7 and lane 1 on pixels 8-15 exactly like SSE2
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + x * 2));
+        __m256i y = _mm256_srli_epi16(v, 8);
+        __m256i uv = _mm256_and_si256(v, mask);
+
+        __m256i yLo = _mm256_madd_epi16(_mm256_unpacklo_epi16(y, zero), cy);
+        __m256i yHi = _mm256_madd_epi16(_mm256_unpackhi_epi16(y, zero), cy);
+
+        __m256i r = ofxThreadedVideoConvertChannelAVX2(uv, yLo, yHi, k.ru, k.rv, k.rOffset);
+        __m256i g = ofxThreadedVideoConvertChannelAVX2(uv, yLo, yHi, k.gu, k.gv, k.gOffset);
+        __m256i b = ofxThreadedVideoConvertChannelAVX2(uv, yLo, yHi, k.bu, k.bv, k.bOffset);
+
+        __m256i rb = bSwapRB ? _mm256_packus_epi16(b, r) : _mm256_packus_epi16(r, b);
+        __m256i ga = _mm256_packus_epi16(g, alpha);
+        __m256i rg = _mm256_unpacklo_epi8(rb, ga);
+        __m256i ba = _mm256_unpackhi_epi8(rb, ga);
+        __m256i p0 = _mm256_unpacklo_epi16(rg, ba);    // pixels 0-3 | 8-11
+        __m256i p1 = _mm256_unpackhi_epi16(rg, ba);    // pixels 4-7 | 12-15
+
+        if(layout.bytesPerPixel == 4){
+            _mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_permute2x128_si256(p0, p1, 0x20));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4 + 32), _mm256_permute2x128_si256(p0, p1, 0x31));
+        }else{
+            // 12 useful bytes per lane, each store overwrites the last one's tail
+            p0 = _mm256_shuffle_epi8(p0, dropAlpha);
+            p1 = _mm256_shuffle_epi8(p1, dropAlpha);
+            unsigned char * out = dst + x * 3;
+            _mm_storeu_si128((__m128i*)(out), _mm256_castsi256_si128(p0));
+            _mm_storeu_si128((__m128i*)(out + 12), _mm256_castsi256_si128(p1));
+            _mm_storeu_si128((__m128i*)(out + 24), _mm256_extracti128_si256(p0, 1));
+            _mm_storeu_si128((__m128i*)(out + 36), _mm256_extracti128_si256(p1, 1));
+        }
+
+    }
+
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static inline OFX_THREADED_VIDEO_TARGET_SSE2 __m128i ofxThreadedVideoSwizzlePack3SSE2(__m128i p){
+
+    // 4 pixels with rgb in the low 3 bytes of each dword -> 12 bytes,
+    // first squeezing each qword down to 6 bytes then the two halves together
+    const __m128i lo = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+    const __m128i hi = _mm_set_epi32(0x00FFFFFF, 0, 0x00FFFFFF, 0);
+    const __m128i first = _mm_set_epi32(0, 0, 0x0000FFFF, -1);
+
+    __m128i q = _mm_or_si128(_mm_and_si128(p, lo), _mm_srli_epi64(_mm_and_si128(p, hi), 8));
+    return _mm_or_si128(_mm_and_si128(q, first), _mm_srli_si128(_mm_andnot_si128(first, q), 2));
+
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_SSE2 int ofxThreadedVideoSwizzleRowSSE2(const unsigned char * src, unsigned char * dst, int width, ofxThreadedVideoSwizzleType type){
+
+    int x = 0;
+
+    if(type == SWIZZLE_BGRA_TO_RGBA){
+
+        const __m128i ga = _mm_set1_epi32((int)0xFF00FF00);
+        const __m128i rb = _mm_set1_epi32(0x00FF00FF);
+
+        for(; x + 4 <= width; x += 4){
+            __m128i p = _mm_loadu_si128((const __m128i*)(src + x * 4));
+            __m128i swap = _mm_and_si128(p, rb);
+            swap = _mm_or_si128(_mm_slli_epi32(swap, 16), _mm_srli_epi32(swap, 16));
+            _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_or_si128(_mm_and_si128(p, ga), swap));
+        }
+
+    }else{
+
+        // 16 pixels at a time so the 48 bytes go out as 3 whole stores
+        int shift = type == SWIZZLE_ARGB_TO_RGB ? 8 : 0;
+
+        for(; x + 16 <= width; x += 16){
+
+            const __m128i * in = (const __m128i*)(src + x * 4);
+            __m128i p0 = ofxThreadedVideoSwizzlePack3SSE2(_mm_srli_epi32(_mm_loadu_si128(in + 0), shift));
+            __m128i p1 = ofxThreadedVideoSwizzlePack3SSE2(_mm_srli_epi32(_mm_loadu_si128(in + 1), shift));
+            __m128i p2 = ofxThreadedVideoSwizzlePack3SSE2(_mm_srli_epi32(_mm_loadu_si128(in + 2), shift));
+            __m128i p3 = ofxThreadedVideoSwizzlePack3SSE2(_mm_srli_epi32(_mm_loadu_si128(in + 3), shift));
+
+            __m128i * out = (__m128i*)(dst + x * 3);
+            _mm_storeu_si128(out + 0, _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+            _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+            _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+
+        }
+
+    }
+
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_AVX2 int ofxThreadedVideoSwizzleRowAVX2(const unsigned char * src, unsigned char * dst, int width, ofxThreadedVideoSwizzleType type){
+
+    int x = 0;
+
+    if(type == SWIZZLE_BGRA_TO_RGBA){
+
+        const __m256i swap = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                              2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+        for(; x + 8 <= width; x += 8){
+            __m256i p = _mm256_loadu_si256((const __m256i*)(src + x * 4));
+            _mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_shuffle_epi8(p, swap));
+        }
+
+    }else{
+
+        // each lane packs to 12 bytes, then the two lanes are joined into 24
+        const __m256i dropARGB = _mm256_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1,
+                                                  1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+        const __m256i dropRGBA = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                  0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        const __m256i drop = type == SWIZZLE_ARGB_TO_RGB ? dropARGB : dropRGBA;
+
+        for(; x + 8 <= width; x += 8){
+            __m256i p = _mm256_loadu_si256((const __m256i*)(src + x * 4));
+            p = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(p, drop), join);
+            unsigned char * out = dst + x * 3;
+            _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(p));
+            _mm_storel_epi64((__m128i*)(out + 16), _mm256_extracti128_si256(p, 1));
+        }
+
+    }
+
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_SSE2 int ofxThreadedVideoInterleaveRowSSE2(const unsigned char * y, const unsigned char * u, const unsigned char * v, unsigned char * dst, int width){
+
+    int x = 0;
+    for(; x + 16 <= width; x += 16){
+        __m128i luma = _mm_loadu_si128((const __m128i*)(y + x));
+        // NV12 chroma is already Cb Cr pairs
+        __m128i chroma = v == NULL ? _mm_loadu_si128((const __m128i*)(u + x)) :
+                                     _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u + x / 2)), _mm_loadl_epi64((const __m128i*)(v + x / 2)));
+        _mm_storeu_si128((__m128i*)(dst + x * 2), _mm_unpacklo_epi8(chroma, luma));
+        _mm_storeu_si128((__m128i*)(dst + x * 2 + 16), _mm_unpackhi_epi8(chroma, luma));
+    }
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_SSE2 int ofxThreadedVideoScaleAccumulateSSE2(const unsigned char * src, unsigned short * sums, int numBytes, bool bFirst){
+
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for(; x + 16 <= numBytes; x += 16){
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i lo = _mm_unpacklo_epi8(p, zero);
+        __m128i hi = _mm_unpackhi_epi8(p, zero);
+        if(!bFirst){
+            lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i*)(sums + x)));
+            hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i*)(sums + x + 8)));
+        }
+        _mm_storeu_si128((__m128i*)(sums + x), lo);
+        _mm_storeu_si128((__m128i*)(sums + x + 8), hi);
+    }
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static OFX_THREADED_VIDEO_TARGET_AVX2 int ofxThreadedVideoScaleAccumulateAVX2(const unsigned char * src, unsigned short * sums, int numBytes, bool bFirst){
+
+    int x = 0;
+    for(; x + 32 <= numBytes; x += 32){
+        __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + x)));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + x + 16)));
+        if(!bFirst){
+            lo = _mm256_add_epi16(lo, _mm256_loadu_si256((const __m256i*)(sums + x)));
+            hi = _mm256_add_epi16(hi, _mm256_loadu_si256((const __m256i*)(sums + x + 16)));
+        }
+        _mm256_storeu_si256((__m256i*)(sums + x), lo);
+        _mm256_storeu_si256((__m256i*)(sums + x + 16), hi);
+    }
+    return x;
+
+}
+
+//--------------------------------------------------------------
+static bool ofxThreadedVideoConvertHasSSE2(){
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+//--------------------------------------------------------------
+static bool ofxThreadedVideoConvertHasAVX2(){
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) return false;
+    __cpuid(info, 1);
+    // the os has to save ymm registers too
+    bool bOSXSave = (info[2] & (1 << 27)) != 0;
+    bool bAVX = (info[2] & (1 << 28)) != 0;
+    if(!bOSXSave || !bAVX || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoConvertRow(const unsigned char * in, unsigned char * out, int width, ofxThreadedVideoConvertKernel kernel,
+                                       const ofxThreadedVideoConvertLayout& layout, const ofxThreadedVideoConvertCoefficients& k){
+    int x = 0;
+#if OFX_THREADED_VIDEO_CONVERT_X86
+    if(kernel == CONVERT_KERNEL_AVX2) x = ofxThreadedVideoConvertRowAVX2(in, out, width, layout, k);
+    if(kernel == CONVERT_KERNEL_SSE2) x = ofxThreadedVideoConvertRowSSE2(in, out, width, layout, k);
+#endif
+    ofxThreadedVideoConvertRowScalar(in, out, x, width, layout, k);
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoInterleaveRow(const unsigned char * y, const unsigned char * u, const unsigned char * v, unsigned char * dst, int width,
+                                          int chromaWidth, ofxThreadedVideoConvertKernel kernel){
+
+    // planar rows to one 2vuy row, so the YUY2 kernels can do the rest
+    int x = 0;
+#if OFX_THREADED_VIDEO_CONVERT_X86
+    // 16 pixels read 8 chroma samples per plane (16 interleaved)
+    if(kernel != CONVERT_KERNEL_SCALAR) x = ofxThreadedVideoInterleaveRowSSE2(y, u, v, dst, MIN(width, chromaWidth * 2));
+#endif
+    for(; x < width; x += 2){
+        int chroma = MIN(x / 2, chromaWidth - 1);
+        dst[x * 2] = v == NULL ? u[chroma * 2] : u[chroma];
+        dst[x * 2 + 1] = y[x];
+        if(x + 1 < width){
+            dst[x * 2 + 2] = v == NULL ? u[chroma * 2 + 1] : v[chroma];
+            dst[x * 2 + 3] = y[x + 1];
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoScaleAccumulate(const unsigned char * src, unsigned short * sums, int numBytes, bool bFirst, ofxThreadedVideoConvertKernel kernel){
+    int x = 0;
+#if OFX_THREADED_VIDEO_CONVERT_X86
+    if(kernel == CONVERT_KERNEL_AVX2) x = ofxThreadedVideoScaleAccumulateAVX2(src, sums, numBytes, bFirst);
+    if(kernel == CONVERT_KERNEL_SSE2) x = ofxThreadedVideoScaleAccumulateSSE2(src, sums, numBytes, bFirst);
+#endif
+    ofxThreadedVideoScaleAccumulateScalar(src, sums, x, numBytes, bFirst);
+}
+
+static ofxThreadedVideoConvertKernel ofxThreadedVideoConvertRequestedKernel = CONVERT_KERNEL_AUTO;
+static int ofxThreadedVideoConvertRequestedThreads = 0;
+static int ofxThreadedVideoConvertRequestedSlices = 0;
+static ofMutex ofxThreadedVideoConvertPoolMutex;
+static atomic<bool> ofxThreadedVideoConvertPoolReady(false);   // only set once setup() has returned
+
+// one frame's rows, split into numSlices bands
+struct ofxThreadedVideoConvertJob {
+    function<void(int, int)> convertRows;
+    int height;
+    int numSlices;
+    int remaining;
+    ofMutex mutex;
+    condition_variable done;
+};
+
+class ofxThreadedVideoConvertSlice : public ofxThreadedVideoTask {
+
+public:
+
+    void runTask(){
+        job->convertRows(job->height * slice / job->numSlices, job->height * (slice + 1) / job->numSlices);
+        // notify under the lock: the job lives on the caller's stack and
+        // is gone the moment it sees remaining hit zero
+        ofScopedLock lock(job->mutex);
+        if(--job->remaining == 0) job->done.notify_one();
+    }
+
+    ofxThreadedVideoConvertJob * job;
+    int slice;
+
+};
+
+//--------------------------------------------------------------
+static ofxThreadedVideoPool& ofxThreadedVideoConvertGetPool(){
+    static ofxThreadedVideoPool pool;
+    return pool;
+}
+
+//--------------------------------------------------------------
+static void ofxThreadedVideoConvertRunSliced(int height, int numSlices, function<void(int, int)> convertRows){
+
+    if(numSlices <= 1){
+        convertRows(0, height);
+        return;
+    }
+
+    ofxThreadedVideoPool& pool = ofxThreadedVideoConvertGetPool();
+    if(!ofxThreadedVideoConvertPoolReady){
+        ofScopedLock lock(ofxThreadedVideoConvertPoolMutex);
+        if(!pool.isSetup()) pool.setup(ofxThreadedVideoConvert::getNumThreads());
+        ofxThreadedVideoConvertPoolReady = true;
+    }
+
+    ofxThreadedVideoConvertJob job;
+    job.convertRows = convertRows;
+    job.height = height;
+    job.numSlices = numSlices;
+    job.remaining = numSlices - 1;
+
+    // hand out all but the first slice, which this thread does itself
+    vector<ofxThreadedVideoConvertSlice> slices(numSlices);
+    for(int i = 1; i < numSlices; i++){
+        slices[i].job = &job;
+        slices[i].slice = i;
+        pool.submit(&slices[i]);
+    }
+    convertRows(0, height / numSlices);
+
+    ofScopedLock lock(job.mutex);
+    while(job.remaining > 0) job.done.wait(lock);
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::yuy2ToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat, int conversionType){
+
+#if (OF_VERSION_MAJOR == 0) && (OF_VERSION_MINOR <= 8)
+    if(src.getPixelFormat() != OF_PIXELS_2YUV){
+#else
+    if(src.getPixelFormat() != OF_PIXELS_YUY2){
+#endif
+        ofLogError("ofxThreadedVideoConvert") << "Source pixels are not YUY2";
+        return false;
+    }
+
+    if(!isPixelFormatSupported(pixelFormat)){
+        ofLogError("ofxThreadedVideoConvert") << "Can only convert to RGB, RGBA or BGRA";
+        return false;
+    }
+
+    int width = src.getWidth();
+    int height = src.getHeight();
+
+    if(dst.getWidth() != width || dst.getHeight() != height || dst.getPixelFormat() != pixelFormat || dst.getPixels() == NULL){
+        dst.allocate(width, height, pixelFormat);
+    }
+
+    ofxThreadedVideoConvertLayout layout = ofxThreadedVideoConvertGetLayout(pixelFormat);
+
+    return yuy2ToPixels(src.getPixels(), width * 2, dst.getPixels(), width * layout.bytesPerPixel, width, height, pixelFormat, conversionType);
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::yuy2ToPixels(const unsigned char * src, int srcStride,
+                                           unsigned char * dst, int dstStride,
+                                           int width, int height,
+                                           ofPixelFormat pixelFormat, int conversionType){
+
+    if(src == NULL || dst == NULL || width <= 0 || height <= 0) return false;
+    if(!isPixelFormatSupported(pixelFormat)) return false;
+
+    const ofxThreadedVideoConvertCoefficients& k = ofxThreadedVideoConvertGetCoefficients(conversionType);
+    ofxThreadedVideoConvertLayout layout = ofxThreadedVideoConvertGetLayout(pixelFormat);
+    ofxThreadedVideoConvertKernel kernel = getActiveKernel();
+
+    ofxThreadedVideoConvertRunSliced(height, getNumSlices(width, height), [&](int rowStart, int rowEnd){
+        for(int row = rowStart; row < rowEnd; row++){
+
+            ofxThreadedVideoConvertRow(src + (size_t)row * srcStride, dst + (size_t)row * dstStride, width, kernel, layout, k);
+        }
+    });
+
+    return true;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::planarToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat, int conversionType){
+
+    ofPixelFormat srcPixelFormat = src.getPixelFormat();
+    if(srcPixelFormat != OF_PIXELS_I420 && srcPixelFormat != OF_PIXELS_NV12){
+        ofLogError("ofxThreadedVideoConvert") << "Source pixels are not I420 or NV12";
+        return false;
+    }
+
+    if(!isPixelFormatSupported(pixelFormat)){
+        ofLogError("ofxThreadedVideoConvert") << "Can only convert to RGB, RGBA or BGRA";
+        return false;
+    }
+
+    int width = src.getWidth();
+    int height = src.getHeight();
+
+    if(dst.getWidth() != width || dst.getHeight() != height || dst.getPixelFormat() != pixelFormat || dst.getPixels() == NULL){
+        dst.allocate(width, height, pixelFormat);
+    }
+
+    ofxThreadedVideoConvertLayout layout = ofxThreadedVideoConvertGetLayout(pixelFormat);
+
+    // same plane layout as ofPixels: Y, then U and V (or interleaved UV) at half size
+    const unsigned char * y = src.getPixels();
+    const unsigned char * u = y + (size_t)width * height;
+    const unsigned char * v = NULL;
+    int chromaStride = width / 2;
+    if(srcPixelFormat == OF_PIXELS_I420){
+        v = u + (size_t)(width / 2) * (height / 2);
+    }else{
+        chromaStride = (width / 2) * 2;
+    }
+
+    return planarToPixels(y, width, u, v, chromaStride, dst.getPixels(), width * layout.bytesPerPixel, width, height, pixelFormat, conversionType);
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::planarToPixels(const unsigned char * y, int yStride,
+                                             const unsigned char * u, const unsigned char * v, int chromaStride,
+                                             unsigned char * dst, int dstStride,
+                                             int width, int height,
+                                             ofPixelFormat pixelFormat, int conversionType){
+
+    if(y == NULL || u == NULL || dst == NULL || width <= 0 || height <= 0) return false;
+    if(!isPixelFormatSupported(pixelFormat)) return false;
+
+    const ofxThreadedVideoConvertCoefficients& k = ofxThreadedVideoConvertGetCoefficients(conversionType);
+    ofxThreadedVideoConvertLayout layout = ofxThreadedVideoConvertGetLayout(pixelFormat);
+    ofxThreadedVideoConvertKernel kernel = getActiveKernel();
+
+    int chromaWidth = MAX(width / 2, 1);
+    int chromaHeight = MAX(height / 2, 1);
+
+    ofxThreadedVideoConvertRunSliced(height, getNumSlices(width, height), [&](int rowStart, int rowEnd){
+        vector<unsigned char> interleaved(width * 2 + 4);
+        for(int row = rowStart; row < rowEnd; row++){
+            size_t chromaRow = (size_t)MIN(row / 2, chromaHeight - 1) * chromaStride;
+            ofxThreadedVideoInterleaveRow(y + (size_t)row * yStride, u + chromaRow, v == NULL ? NULL : v + chromaRow, &interleaved[0], width, chromaWidth, kernel);
+            ofxThreadedVideoConvertRow(&interleaved[0], dst + (size_t)row * dstStride, width, kernel, layout, k);
+        }
+    });
+
+    return true;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::yuvToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat, int conversionType){
+    if(isPlanarPixelFormat(src.getPixelFormat())) return planarToPixels(src, dst, pixelFormat, conversionType);
+    return yuy2ToPixels(src, dst, pixelFormat, conversionType);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::isYUVPixelFormat(ofPixelFormat pixelFormat){
+#if (OF_VERSION_MAJOR == 0) && (OF_VERSION_MINOR <= 8)
+    return pixelFormat == OF_PIXELS_2YUV || isPlanarPixelFormat(pixelFormat);
+#else
+    return pixelFormat == OF_PIXELS_YUY2 || isPlanarPixelFormat(pixelFormat);
+#endif
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::isPlanarPixelFormat(ofPixelFormat pixelFormat){
+    return pixelFormat == OF_PIXELS_I420 || pixelFormat == OF_PIXELS_NV12;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::isPixelFormatSupported(ofPixelFormat pixelFormat){
+    return pixelFormat == OF_PIXELS_RGB || pixelFormat == OF_PIXELS_RGBA || pixelFormat == OF_PIXELS_BGRA;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::swizzlePixels(const unsigned char * src, int srcStride,
+                                            unsigned char * dst, int dstStride,
+                                            int width, int height,
+                                            ofxThreadedVideoSwizzleType type, bool bFlipVertically){
+
+    if(src == NULL || dst == NULL || width <= 0 || height <= 0) return false;
+
+    ofxThreadedVideoConvertKernel kernel = getActiveKernel();
+
+    ofxThreadedVideoConvertRunSliced(height, getNumSlices(width, height), [&](int rowStart, int rowEnd){
+        for(int row = rowStart; row < rowEnd; row++){
+
+            const unsigned char * in = src + (size_t)row * srcStride;
+            unsigned char * out = dst + (size_t)(bFlipVertically ? height - 1 - row : row) * dstStride;
+
+            int x = 0;
+#if OFX_THREADED_VIDEO_CONVERT_X86
+            if(kernel == CONVERT_KERNEL_AVX2) x = ofxThreadedVideoSwizzleRowAVX2(in, out, width, type);
+            if(kernel == CONVERT_KERNEL_SSE2) x = ofxThreadedVideoSwizzleRowSSE2(in, out, width, type);
+#endif
+            ofxThreadedVideoSwizzleRowScalar(in, out, x, width, type);
+
+        }
+    });
+
+    return true;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::scalePixels(const ofPixels& src, ofPixels& dst, int width, int height){
+
+    ofPixelFormat pixelFormat = src.getPixelFormat();
+    if(!isScaleSupported(pixelFormat)){
+        ofLogError("ofxThreadedVideoConvert") << "Can only scale RGB, RGBA, BGRA, grayscale, YUY2, I420 or NV12 pixels";
+        return false;
+    }
+
+    int srcWidth = src.getWidth();
+    int srcHeight = src.getHeight();
+
+    // YUV frames have to keep whole chroma samples
+    bool bYUV = isYUVPixelFormat(pixelFormat);
+    bool bPlanar = isPlanarPixelFormat(pixelFormat);
+    width = CLAMP(width, bYUV ? 2 : 1, srcWidth);
+    height = CLAMP(height, bPlanar ? 2 : 1, srcHeight);
+    if(bYUV) width &= ~1;
+    if(bPlanar) height &= ~1;
+
+    if(dst.getWidth() != width || dst.getHeight() != height || dst.getPixelFormat() != pixelFormat || dst.getPixels() == NULL){
+        dst.allocate(width, height, pixelFormat);
+    }
+
+    const unsigned char * in = src.getPixels();
+    unsigned char * out = dst.getPixels();
+
+    if(bPlanar){
+        // luma, then U and V (or interleaved UV) at half size
+        int srcChromaWidth = srcWidth / 2;
+        int srcChromaHeight = srcHeight / 2;
+        int chromaWidth = width / 2;
+        int chromaHeight = height / 2;
+        if(!scalePlane(in, srcWidth, srcWidth, srcHeight, out, width, width, height, 1)) return false;
+        in += (size_t)srcWidth * srcHeight;
+        out += (size_t)width * height;
+        if(pixelFormat == OF_PIXELS_NV12){
+            return scalePlane(in, srcChromaWidth * 2, srcChromaWidth, srcChromaHeight, out, chromaWidth * 2, chromaWidth, chromaHeight, 2);
+        }
+        if(!scalePlane(in, srcChromaWidth, srcChromaWidth, srcChromaHeight, out, chromaWidth, chromaWidth, chromaHeight, 1)) return false;
+        in += (size_t)srcChromaWidth * srcChromaHeight;
+        out += (size_t)chromaWidth * chromaHeight;
+        return scalePlane(in, srcChromaWidth, srcChromaWidth, srcChromaHeight, out, chromaWidth, chromaWidth, chromaHeight, 1);
+    }
+
+    if(bYUV){
+        // Cb Y0 Cr Y1: luma and chroma are pulled apart and scaled as their
+        // own planes, so every luma sample is averaged with its neighbours
+        // rather than only with the Y0s (or Y1s) of other pairs
+        int srcPairs = srcWidth / 2;
+        int pairs = width / 2;
+        vector<unsigned char> luma((size_t)srcPairs * 2 * srcHeight);
+        vector<unsigned char> chroma((size_t)srcPairs * 2 * srcHeight);
+        for(int row = 0; row < srcHeight; row++){
+            const unsigned char * pair = in + (size_t)row * srcWidth * 2;
+            unsigned char * y = &luma[(size_t)row * srcPairs * 2];
+            unsigned char * uv = &chroma[(size_t)row * srcPairs * 2];
+            for(int x = 0; x < srcPairs * 2; x += 2, pair += 4){
+                uv[x] = pair[0];
+                y[x] = pair[1];
+                uv[x + 1] = pair[2];
+                y[x + 1] = pair[3];
+            }
+        }
+        vector<unsigned char> scaledLuma((size_t)width * height);
+        vector<unsigned char> scaledChroma((size_t)width * height);
+        if(!scalePlane(&luma[0], srcPairs * 2, srcPairs * 2, srcHeight, &scaledLuma[0], width, width, height, 1)) return false;
+        if(!scalePlane(&chroma[0], srcPairs * 2, srcPairs, srcHeight, &scaledChroma[0], pairs * 2, pairs, height, 2)) return false;
+        for(size_t i = 0; i < scaledLuma.size(); i += 2, out += 4){
+            out[0] = scaledChroma[i];
+            out[1] = scaledLuma[i];
+            out[2] = scaledChroma[i + 1];
+            out[3] = scaledLuma[i + 1];
+        }
+        return true;
+    }
+
+    int numChannels = src.getNumChannels();
+    return scalePlane(in, srcWidth * numChannels, srcWidth, srcHeight, out, width * numChannels, width, height, numChannels);
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::scalePlane(const unsigned char * src, int srcStride, int srcWidth, int srcHeight,
+                                         unsigned char * dst, int dstStride, int width, int height, int numChannels){
+
+    if(src == NULL || dst == NULL || width <= 0 || height <= 0 || numChannels < 1 || numChannels > 4) return false;
+    if(width > srcWidth || height > srcHeight) return false;
+
+    // column sums are 16 bit, which holds 257 rows of 255. taller
+    // reductions add each run of 257 rows into 32 bit sums as they go
+    const int maxShortRows = 257;
+    int maxRows = (srcHeight + height - 1) / height;
+    bool bWide = maxRows > maxShortRows;
+
+    // where each output column starts, and the reciprocal of its area for
+    // the two row counts an output row can cover (srcHeight / height
+    // rounded down and up)
+    vector<int> columns(width + 1);
+    for(int x = 0; x <= width; x++) columns[x] = (int)((long long)x * srcWidth / width);
+    int minRows = srcHeight / height;
+    vector<unsigned long long> recips[2];
+    for(int i = 0; i < 2; i++){
+        recips[i].resize(width);
+        for(int x = 0; x < width; x++){
+            unsigned long long area = (unsigned long long)(columns[x + 1] - columns[x]) * (minRows + i);
+            recips[i][x] = ((1ULL << 32) + area - 1) / area;
+        }
+    }
+
+    ofxThreadedVideoConvertKernel kernel = getActiveKernel();
+    int rowBytes = srcWidth * numChannels;
+
+    ofxThreadedVideoConvertRunSliced(height, getNumSlices(srcWidth, srcHeight), [&](int rowStart, int rowEnd){
+        vector<unsigned short> sums(rowBytes);
+        vector<unsigned int> wideSums(bWide ? rowBytes : 0);
+        for(int row = rowStart; row < rowEnd; row++){
+
+            int first = (int)((long long)row * srcHeight / height);
+            int last = (int)((long long)(row + 1) * srcHeight / height);
+            for(int runStart = first; runStart < last; runStart += maxShortRows){
+                int runEnd = MIN(last, runStart + maxShortRows);
+                for(int y = runStart; y < runEnd; y++){
+                    ofxThreadedVideoScaleAccumulate(src + (size_t)y * srcStride, &sums[0], rowBytes, y == runStart, kernel);
+                }
+                if(!bWide) continue;
+                if(runStart == first){
+                    for(int i = 0; i < rowBytes; i++) wideSums[i] = sums[i];
+                }else{
+                    for(int i = 0; i < rowBytes; i++) wideSums[i] += sums[i];
+                }
+            }
+
+            unsigned char * out = dst + (size_t)row * dstStride;
+            const unsigned long long * rowRecips = &recips[last - first - minRows][0];
+            if(bWide){
+                ofxThreadedVideoScaleRow<unsigned int, unsigned long long>(&wideSums[0], out, width, numChannels, &columns[0], rowRecips);
+            }else{
+                ofxThreadedVideoScaleRow<unsigned short, unsigned int>(&sums[0], out, width, numChannels, &columns[0], rowRecips);
+            }
+
+        }
+    });
+
+    return true;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::isScaleSupported(ofPixelFormat pixelFormat){
+#if (OF_VERSION_MAJOR == 0) && (OF_VERSION_MINOR <= 8)
+    if(pixelFormat == OF_PIXELS_MONO) return true;
+#else
+    if(pixelFormat == OF_PIXELS_GRAY) return true;
+#endif
+    return isPixelFormatSupported(pixelFormat) || isYUVPixelFormat(pixelFormat);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::getScaledSize(int width, int height, int maxWidth, int maxHeight, int& scaledWidth, int& scaledHeight){
+
+    scaledWidth = width;
+    scaledHeight = height;
+    if(width <= 0 || height <= 0) return false;
+
+    double scale = 1.0;
+    if(maxWidth > 0) scale = MIN(scale, (double)maxWidth / width);
+    if(maxHeight > 0) scale = MIN(scale, (double)maxHeight / height);
+    if(scale >= 1.0) return false;
+
+    // even, so YUV frames scale to the same size as everything else
+    int w = MAX(2, (int)(width * scale + 0.0001) & ~1);
+    int h = MAX(2, (int)(height * scale + 0.0001) & ~1);
+    if(w >= width && h >= height) return false;
+
+    scaledWidth = MIN(w, width);
+    scaledHeight = MIN(h, height);
+    return true;
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoConvert::setNumThreads(int numThreads){
+    // slices may be queued on the running pool, so it's never restarted
+    ofScopedLock lock(ofxThreadedVideoConvertPoolMutex);
+    if(ofxThreadedVideoConvertPoolReady){
+        ofLogWarning("ofxThreadedVideoConvert") << "setNumThreads() has to be called before the first frame is split";
+        return;
+    }
+    ofxThreadedVideoConvertRequestedThreads = MAX(0, numThreads);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoConvert::getNumThreads(){
+    if(ofxThreadedVideoConvertPoolReady) return ofxThreadedVideoConvertGetPool().getNumThreads();
+    if(ofxThreadedVideoConvertRequestedThreads > 0) return ofxThreadedVideoConvertRequestedThreads;
+    // leave a core for the decoders
+    int numCores = thread::hardware_concurrency();
+    return CLAMP(numCores - 1, 1, 4);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoConvert::setNumSlices(int numSlices){
+    ofxThreadedVideoConvertRequestedSlices = MAX(0, numSlices);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoConvert::getNumSlices(){
+    return ofxThreadedVideoConvertRequestedSlices;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoConvert::getNumSlices(int width, int height){
+    int numSlices = ofxThreadedVideoConvertRequestedSlices;
+    if(numSlices == 0){
+        // a slice per OFX_THREADED_VIDEO_CONVERT_SLICE_PIXELS, one per thread
+        // plus the caller at most, and never on a single core
+        if(thread::hardware_concurrency() <= 1) return 1;
+        numSlices = CLAMP((int)(((long long)width * height) / OFX_THREADED_VIDEO_CONVERT_SLICE_PIXELS), 1, getNumThreads() + 1);
+    }
+    return CLAMP(numSlices, 1, MAX(height, 1));
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoConvert::setKernel(ofxThreadedVideoConvertKernel kernel){
+    if(kernel != CONVERT_KERNEL_AUTO && !isKernelSupported(kernel)){
+        ofLogWarning("ofxThreadedVideoConvert") << getKernelName(kernel) << " is not supported on this cpu, using " << getKernelName(getActiveKernel());
+    }
+    ofxThreadedVideoConvertRequestedKernel = kernel;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoConvertKernel ofxThreadedVideoConvert::getKernel(){
+    return ofxThreadedVideoConvertRequestedKernel;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoConvertKernel ofxThreadedVideoConvert::getActiveKernel(){
+    ofxThreadedVideoConvertKernel kernel = ofxThreadedVideoConvertRequestedKernel;
+    if(kernel != CONVERT_KERNEL_AUTO && isKernelSupported(kernel)) return kernel;
+    if(isKernelSupported(CONVERT_KERNEL_AVX2)) return CONVERT_KERNEL_AVX2;
+    if(isKernelSupported(CONVERT_KERNEL_SSE2)) return CONVERT_KERNEL_SSE2;
+    return CONVERT_KERNEL_SCALAR;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoConvert::isKernelSupported(ofxThreadedVideoConvertKernel kernel){
+#if OFX_THREADED_VIDEO_CONVERT_X86
+    static const bool bHasSSE2 = ofxThreadedVideoConvertHasSSE2();
+    static const bool bHasAVX2 = ofxThreadedVideoConvertHasAVX2();
+#else
+    static const bool bHasSSE2 = false;
+    static const bool bHasAVX2 = false;
+#endif
+    switch(kernel){
+        case CONVERT_KERNEL_SCALAR:
+            return true;
+        case CONVERT_KERNEL_SSE2:
+            return bHasSSE2;
+        case CONVERT_KERNEL_AVX2:
+            return bHasAVX2;
+        default:
+            return false;
+    }
+}
+
+//--------------------------------------------------------------
+string ofxThreadedVideoConvert::getKernelName(ofxThreadedVideoConvertKernel kernel){
+    switch(kernel){
+        case CONVERT_KERNEL_AUTO:
+            return "auto";
+        case CONVERT_KERNEL_SCALAR:
+            return "scalar";
+        case CONVERT_KERNEL_SSE2:
+            return "SSE2";
+        case CONVERT_KERNEL_AVX2:
+            return "AVX2";
+        default:
+            return "unknown";
+    }
+}
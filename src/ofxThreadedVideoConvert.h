@@ -0,0 +1,162 @@
+/*
+ * ofxThreadedVideoConvert.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#ifndef __H_OFXTHREADEDVIDEOCONVERT
+#define __H_OFXTHREADEDVIDEOCONVERT
+
+#include <functional>
+#include <condition_variable>
+
+#include "ofMain.h"
+#include "ofxThreadedVideoPool.h"
+
+// frames bigger than this get split across the conversion threads
+#define OFX_THREADED_VIDEO_CONVERT_SLICE_PIXELS (512 * 1024)
+
+enum ofxThreadedVideoConvertKernel{
+    CONVERT_KERNEL_AUTO = 0,    // fastest kernel the cpu supports
+    CONVERT_KERNEL_SCALAR,
+    CONVERT_KERNEL_SSE2,
+    CONVERT_KERNEL_AVX2
+};
+
+// byte order in memory, whatever the endianness
+enum ofxThreadedVideoSwizzleType{
+    SWIZZLE_ARGB_TO_RGB = 0,    // QuickTime's k32ARGBPixelFormat gworlds
+    SWIZZLE_RGBA_TO_RGB,
+    SWIZZLE_BGRA_TO_RGBA        // same swap works for RGBA to BGRA
+};
+
+// cpu side YUY2 (QuickTime's 2vuy byte order: Cb Y0 Cr Y1), I420 and NV12 to
+// RGB, RGBA or BGRA conversion for anything that wants the pixels rather than the
+// texture - it uses exactly the same BT.601/BT.709 constants as the
+// internal shader so a frame looks the same either way.
+//
+// the math is 13 bit fixed point and every kernel produces identical
+// output, the SIMD ones just do 8 (SSE2) or 16 (AVX2) pixels at a time.
+// the kernel is picked at runtime from what the cpu supports.
+//
+// the same kernels also do the plain byte swizzles (dropping alpha,
+// swapping red and blue) with an optional vertical flip in the same pass.
+//
+// it also box filters frames down to a smaller size (every output pixel
+// is the average of the source pixels it covers), summing rows with the
+// SIMD kernels, for thumbnails that don't need full size frames.
+//
+// big frames are split into bands of rows that run in parallel on a small
+// pool of conversion threads shared by every instance, with the calling
+// thread doing a band too; the call returns once the whole frame is done.
+class ofxThreadedVideoConvert {
+
+public:
+
+    // dst is (re)allocated if its size or format doesn't match;
+    // conversionType is 601 or 709 like the shader uniform
+    static bool yuy2ToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat = OF_PIXELS_RGB, int conversionType = 601);
+
+    // strides are in bytes
+    static bool yuy2ToPixels(const unsigned char * src, int srcStride,
+                             unsigned char * dst, int dstStride,
+                             int width, int height,
+                             ofPixelFormat pixelFormat, int conversionType = 601);
+
+    // 4:2:0 planar frames (ofPixels' I420 or NV12 layout) to RGB, RGBA or
+    // BGRA: each row is interleaved to YUY2 and run through the same kernels
+    static bool planarToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat = OF_PIXELS_RGB, int conversionType = 601);
+
+    // chroma planes are half width and height; for NV12 pass the UV plane
+    // as u and NULL for v, its stride covers both samples
+    static bool planarToPixels(const unsigned char * y, int yStride,
+                               const unsigned char * u, const unsigned char * v, int chromaStride,
+                               unsigned char * dst, int dstStride,
+                               int width, int height,
+                               ofPixelFormat pixelFormat, int conversionType = 601);
+
+    // YUY2, I420 or NV12, whichever src is
+    static bool yuvToPixels(const ofPixels& src, ofPixels& dst, ofPixelFormat pixelFormat = OF_PIXELS_RGB, int conversionType = 601);
+
+    static bool isYUVPixelFormat(ofPixelFormat pixelFormat);
+    static bool isPlanarPixelFormat(ofPixelFormat pixelFormat);
+
+    // output formats
+    static bool isPixelFormatSupported(ofPixelFormat pixelFormat);
+
+    // src and dst must not overlap
+    static bool swizzlePixels(const unsigned char * src, int srcStride,
+                              unsigned char * dst, int dstStride,
+                              int width, int height,
+                              ofxThreadedVideoSwizzleType type, bool bFlipVertically = false);
+
+    // scale RGB, RGBA, BGRA, grayscale, YUY2, I420 or NV12 pixels down to
+    // width x height (never up), keeping src's format. YUV frames get an
+    // even width (and height for planar) so chroma stays whole. dst is
+    // (re)allocated if its size or format doesn't match
+    static bool scalePixels(const ofPixels& src, ofPixels& dst, int width, int height);
+
+    // one plane of 1 to 4 interleaved 8 bit channels, strides in bytes
+    static bool scalePlane(const unsigned char * src, int srcStride, int srcWidth, int srcHeight,
+                           unsigned char * dst, int dstStride, int width, int height, int numChannels);
+
+    static bool isScaleSupported(ofPixelFormat pixelFormat);
+
+    // the even size a width x height frame scales down to so it fits in
+    // maxWidth x maxHeight with the same aspect (0 = no limit on that
+    // side); returns false if it already fits
+    static bool getScaledSize(int width, int height, int maxWidth, int maxHeight, int& scaledWidth, int& scaledHeight);
+
+    // threads in the shared conversion pool; 0 = one less than the number
+    // of cores, at most 4. the pool starts with the first frame that gets
+    // split and can't be resized after that
+    static void setNumThreads(int numThreads);
+    static int getNumThreads();
+
+    // bands each frame is split into; 0 = adapt to the frame size (the
+    // default), 1 = always convert on the calling thread
+    static void setNumSlices(int numSlices);
+    static int getNumSlices();
+
+    // the number of bands a frame this size will actually use
+    static int getNumSlices(int width, int height);
+
+    // force a kernel (mostly for benchmarking); unsupported kernels fall
+    // back to the best one available
+    static void setKernel(ofxThreadedVideoConvertKernel kernel);
+    static ofxThreadedVideoConvertKernel getKernel();
+
+    // the kernel that will actually run
+    static ofxThreadedVideoConvertKernel getActiveKernel();
+
+    static bool isKernelSupported(ofxThreadedVideoConvertKernel kernel);
+    static string getKernelName(ofxThreadedVideoConvertKernel kernel);
+
+};
+
+#endif
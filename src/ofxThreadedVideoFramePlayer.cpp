@@ -0,0 +1,365 @@
+/*
+ * ofxThreadedVideoFramePlayer.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#include "ofxThreadedVideoFramePlayer.h"
+
+//--------------------------------------------------------------
+ofxThreadedVideoFramePlayer::ofxThreadedVideoFramePlayer(){
+    pixelFormat = OF_PIXELS_RGB;
+    width = height = numFrames = 0;
+    frameRate = 0;
+    bounce = 1;
+    clock = 0;
+    currentFrame = -1;
+    bNeedsFrame = false;
+    bLoaded = bPlaying = bPaused = bIsFrameNew = bIsMovieDone = false;
+    speed = 1;
+    loopState = OF_LOOP_NORMAL;
+    timeLastUpdate = 0;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoFramePlayer::~ofxThreadedVideoFramePlayer(){
+    // subclasses have to close() in their own destructor, closeFrames() is gone by now
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::load(string name){
+
+    close();
+
+    string path = ofToDataPath(name, true);
+
+    width = height = numFrames = 0;
+    frameRate = 0;
+
+    if(!openFrames(path)){
+        closeFrames();
+        return false;
+    }
+
+    if(numFrames <= 0 || width <= 0 || height <= 0){
+        ofLogError("ofxThreadedVideoFramePlayer") << "load(): no frames in " << path;
+        closeFrames();
+        return false;
+    }
+
+    if(frameRate <= 0) frameRate = 25;
+
+    bLoaded = true;
+    bPlaying = bPaused = bIsMovieDone = false;
+    clock = 0;
+    currentFrame = -1;
+
+    // have the first frame ready like any other backend
+    if(!readFrame(0)){
+        close();
+        return false;
+    }
+
+    currentFrame = 0;
+    bNeedsFrame = false;
+    bIsFrameNew = true;
+    setBounce(1);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::close(){
+    if(!bLoaded) return;
+    closeFrames();
+    pixels.clear();
+    bLoaded = bPlaying = bPaused = bIsFrameNew = bIsMovieDone = false;
+    currentFrame = -1;
+    clock = 0;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::update(){
+
+    if(!bLoaded) return;
+
+    bIsFrameNew = false;
+
+    unsigned long long timeNow = ofGetElapsedTimeMicros();
+    if(bPlaying && !bPaused && !bIsMovieDone && timeLastUpdate > 0){
+        advance((timeNow - timeLastUpdate) / 1000000.0 * frameRate * speed);
+    }
+    timeLastUpdate = timeNow;
+
+    int frame = CLAMP((int)clock, 0, numFrames - 1);
+    if(frame != currentFrame || bNeedsFrame){
+        bNeedsFrame = false;
+        if(readFrame(frame)){
+            currentFrame = frame;
+            bIsFrameNew = true;
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::advance(double numFramesElapsed){
+
+    clock += numFramesElapsed * bounce;
+
+    int lastFrame = numFrames - 1;
+
+    switch(loopState){
+        case OF_LOOP_NONE:
+        {
+            // done once the last frame has had its time, not as it starts
+            if(clock >= numFrames){
+                clock = lastFrame;
+                bIsMovieDone = true;
+            }else if(clock < 0){
+                clock = 0;
+                bIsMovieDone = true;
+            }
+            break;
+        }
+        case OF_LOOP_NORMAL:
+        {
+            clock = fmod(clock, (double)numFrames);
+            if(clock < 0) clock += numFrames;
+            break;
+        }
+        case OF_LOOP_PALINDROME:
+        {
+            if(lastFrame == 0){
+                clock = 0;
+                break;
+            }
+            int newBounce = bounce;
+            while(clock > lastFrame || clock < 0){
+                clock = clock > lastFrame ? 2 * lastFrame - clock : -clock;
+                newBounce = -newBounce;
+            }
+            setBounce(newBounce);
+            break;
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::seekTo(double frame){
+    clock = CLAMP(frame, 0.0, (double)(numFrames - 1));
+    bIsMovieDone = false;
+    bNeedsFrame = true;
+    timeLastUpdate = ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setBounce(int newBounce){
+    if(newBounce == bounce) return;
+    bounce = newBounce;
+    directionChanged(getDirection());
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoFramePlayer::getDirection() const{
+    return (speed < 0 ? -1 : 1) * bounce;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::play(){
+    if(!bLoaded){
+        ofLogError("ofxThreadedVideoFramePlayer") << "play(): movie not loaded";
+        return;
+    }
+    bPlaying = true;
+    bPaused = false;
+    timeLastUpdate = ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::stop(){
+    if(!bLoaded){
+        ofLogError("ofxThreadedVideoFramePlayer") << "stop(): movie not loaded";
+        return;
+    }
+    bPlaying = false;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setPaused(bool bPause){
+    bPaused = bPause;
+    timeLastUpdate = ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::setPixelFormat(ofPixelFormat _pixelFormat){
+    if(!isPixelFormatSupported(_pixelFormat)){
+        ofLogWarning("ofxThreadedVideoFramePlayer") << "setPixelFormat(): requested pixel format " << _pixelFormat << " not supported";
+        return false;
+    }
+    if(pixelFormat == _pixelFormat) return true;
+    pixelFormat = _pixelFormat;
+    // convert whatever is showing again
+    if(bLoaded) bNeedsFrame = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+ofPixelFormat ofxThreadedVideoFramePlayer::getPixelFormat() const{
+    return pixelFormat;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::isFrameNew() const{
+    return bIsFrameNew;
+}
+
+//--------------------------------------------------------------
+ofPixels& ofxThreadedVideoFramePlayer::getPixels(){
+    return pixels;
+}
+
+//--------------------------------------------------------------
+const ofPixels& ofxThreadedVideoFramePlayer::getPixels() const{
+    return pixels;
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideoFramePlayer::getWidth() const{
+    return width;
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideoFramePlayer::getHeight() const{
+    return height;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::isPaused() const{
+    return bPaused;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::isLoaded() const{
+    return bLoaded;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::isPlaying() const{
+    return bPlaying;
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideoFramePlayer::getPosition() const{
+    if(!bLoaded) return 0.0f;
+    return clock / numFrames;
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideoFramePlayer::getDuration() const{
+    if(!bLoaded) return 0.0f;
+    return numFrames / frameRate;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoFramePlayer::getTotalNumFrames() const{
+    return numFrames;
+}
+
+//--------------------------------------------------------------
+float ofxThreadedVideoFramePlayer::getSpeed() const{
+    return speed;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoFramePlayer::getIsMovieDone() const{
+    return bIsMovieDone;
+}
+
+//--------------------------------------------------------------
+ofLoopType ofxThreadedVideoFramePlayer::getLoopState() const{
+    return loopState;
+}
+
+//--------------------------------------------------------------
+double ofxThreadedVideoFramePlayer::getFrameRate() const{
+    return frameRate;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setPosition(float pct){
+    if(!bLoaded) return;
+    seekTo(CLAMP(pct, 0.0f, 1.0f) * numFrames);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setVolume(float volume){
+    // no audio in frame backends
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setLoopState(ofLoopType state){
+    loopState = state;
+    if(loopState != OF_LOOP_NONE) bIsMovieDone = false;
+    if(loopState != OF_LOOP_PALINDROME) setBounce(1);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setSpeed(float _speed){
+    bool bReversed = (speed < 0) != (_speed < 0);
+    speed = _speed;
+    if(bReversed) directionChanged(getDirection());
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::setFrame(int frame){
+    if(!bLoaded) return;
+    seekTo(frame);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoFramePlayer::getCurrentFrame() const{
+    return currentFrame;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::firstFrame(){
+    setFrame(0);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::nextFrame(){
+    setFrame(currentFrame + 1);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoFramePlayer::previousFrame(){
+    setFrame(currentFrame - 1);
+}
@@ -0,0 +1,167 @@
+/*
+ * ofxThreadedVideoFramePlayer.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#ifndef __H_OFXTHREADEDVIDEOFRAMEPLAYER
+#define __H_OFXTHREADEDVIDEOFRAMEPLAYER
+
+#include "ofMain.h"
+
+// backends that can decode straight to a smaller size implement this as
+// well as ofBaseVideoPlayer. ofxThreadedVideo::setOutputSize() passes the
+// size on and it's used from the next load; getWidth() and getHeight()
+// keep reporting the media's own size, only the pixels get smaller.
+// anything that still comes out bigger is scaled down by the engine
+class ofxThreadedVideoOutputSize {
+
+public:
+
+    virtual ~ofxThreadedVideoOutputSize(){};
+
+    // frames should fit inside width x height, 0 x 0 = full size
+    virtual void setOutputSize(int width, int height) = 0;
+
+};
+
+// base for backends that can produce any frame on demand (uncompressed
+// streams, raw frame files, image sequences...): it keeps the play clock,
+// loop states and seeking, and subclasses only open the media and fill
+// pixels with a given frame. these don't need QuickTime, GL or a window so
+// they build and run headless anywhere.
+//
+// like every ofxThreadedVideo backend it's only ever used from one thread
+// at a time, so there's no locking in here
+class ofxThreadedVideoFramePlayer : public ofBaseVideoPlayer {
+
+public:
+
+    ofxThreadedVideoFramePlayer();
+    virtual ~ofxThreadedVideoFramePlayer();
+
+    bool load(string name);
+    void close();
+    void update();
+
+    void play();
+    void stop();
+
+    bool setPixelFormat(ofPixelFormat pixelFormat);
+    ofPixelFormat getPixelFormat() const;
+
+    bool isFrameNew() const;
+
+    ofPixels& getPixels();
+    const ofPixels& getPixels() const;
+
+    float getWidth() const;
+    float getHeight() const;
+
+    bool isPaused() const;
+    bool isLoaded() const;
+    bool isPlaying() const;
+
+    float getPosition() const;
+    float getDuration() const;
+    int getTotalNumFrames() const;
+    float getSpeed() const;
+    bool getIsMovieDone() const;
+    ofLoopType getLoopState() const;
+
+    void setPosition(float pct);
+    void setVolume(float volume);
+    void setLoopState(ofLoopType state);
+    void setSpeed(float speed);
+    void setFrame(int frame);
+    void setPaused(bool bPause);
+
+    int getCurrentFrame() const;
+
+    void firstFrame();
+    void nextFrame();
+    void previousFrame();
+
+    double getFrameRate() const;
+
+protected:
+
+    // open path and set width, height, numFrames and frameRate
+    virtual bool openFrames(const string& path) = 0;
+
+    // put frame (0 to numFrames - 1) into pixels in pixelFormat
+    virtual bool readFrame(int frame) = 0;
+
+    virtual void closeFrames() = 0;
+
+    // which of RGB, RGBA, BGRA, YUY2 etc the subclass can produce
+    virtual bool isPixelFormatSupported(ofPixelFormat pixelFormat) const = 0;
+
+    // the play direction changed (speed, palindrome), eg., to turn read-ahead
+    // around: 1 forwards, -1 backwards
+    virtual void directionChanged(int direction){};
+
+    int getDirection() const;
+
+    ofPixels pixels;
+    ofPixelFormat pixelFormat;
+
+    int width;
+    int height;
+    int numFrames;
+    double frameRate;
+
+private:
+
+    void seekTo(double frame);
+    void advance(double numFramesElapsed);
+    void setBounce(int newBounce);
+
+    double clock;           // frames since the start, fractional
+    int currentFrame;       // what's in pixels, -1 for nothing yet
+    int bounce;             // -1 while a palindrome runs back
+    bool bNeedsFrame;
+
+    bool bLoaded;
+    bool bPlaying;
+    bool bPaused;
+    bool bIsFrameNew;
+    bool bIsMovieDone;
+
+    float speed;
+    ofLoopType loopState;
+    unsigned long long timeLastUpdate;
+
+    // block copy ctor and assignment operator
+    ofxThreadedVideoFramePlayer(const ofxThreadedVideoFramePlayer& other);
+    ofxThreadedVideoFramePlayer& operator=(const ofxThreadedVideoFramePlayer&);
+
+};
+
+#endif
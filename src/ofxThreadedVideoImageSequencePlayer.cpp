@@ -0,0 +1,367 @@
+/*
+ * ofxThreadedVideoImageSequencePlayer.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#include "ofxThreadedVideoImageSequencePlayer.h"
+#include "ofxThreadedVideoBufferPool.h"
+#include "ofxThreadedVideoConvert.h"
+
+//--------------------------------------------------------------
+double ofxThreadedVideoImageSequencePlayer::defaultSequenceFrameRate = 30;
+int ofxThreadedVideoImageSequencePlayer::defaultReadAhead = 8;
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::setDefaultSequenceFrameRate(double frameRate){
+    defaultSequenceFrameRate = frameRate;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::setDefaultReadAhead(int numFrames){
+    defaultReadAhead = MAX(numFrames, 0);
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoImageSequencePlayer::ofxThreadedVideoImageSequencePlayer(){
+    sequenceFrameRate = defaultSequenceFrameRate;
+    readAhead = defaultReadAhead;
+    decoder.player = this;
+    outputWidth = outputHeight = 0;
+    frameWidth = frameHeight = 0;
+    bPooledPixels = false;
+    numDecodedAhead = 0;
+    numDecodedLate = 0;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoImageSequencePlayer::~ofxThreadedVideoImageSequencePlayer(){
+    close();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::setSequenceFrameRate(double _frameRate){
+    sequenceFrameRate = _frameRate;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::setReadAhead(int numFrames){
+    ofScopedLock lock(cacheMutex);
+    readAhead = MAX(numFrames, 0);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoImageSequencePlayer::getReadAhead(){
+    ofScopedLock lock(cacheMutex);
+    return readAhead;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::setOutputSize(int width, int height){
+    outputWidth = MAX(width, 0);
+    outputHeight = MAX(height, 0);
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoImageSequencePlayer::getNumCached(){
+    ofScopedLock lock(cacheMutex);
+    return cache.size();
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoImageSequencePlayer::getNumDecodedAhead(){
+    ofScopedLock lock(cacheMutex);
+    return numDecodedAhead;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoImageSequencePlayer::getNumDecodedLate(){
+    ofScopedLock lock(cacheMutex);
+    return numDecodedLate;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoImageSequencePlayer::openFrames(const string& path){
+
+    string folder = path;
+    ofDirectory dir;
+    if(ofDirectory::doesDirectoryExist(path, false)){
+        dir.allowExt("png");
+        dir.allowExt("jpg");
+        dir.allowExt("jpeg");
+        dir.allowExt("tga");
+        dir.allowExt("tif");
+        dir.allowExt("tiff");
+        dir.allowExt("bmp");
+    }else{
+        folder = ofFilePath::getEnclosingDirectory(path, false);
+        dir.allowExt(ofFilePath::getFileExt(path));
+    }
+
+    dir.listDir(folder);
+    dir.sort();
+
+    paths.clear();
+    for(int i = 0; i < dir.size(); i++){
+        paths.push_back(dir.getPath(i));
+    }
+
+    if(paths.size() == 0){
+        ofLogError("ofxThreadedVideoImageSequencePlayer") << "openFrames(): no images in " << folder;
+        return false;
+    }
+
+    // the first frame sets the size for the rest
+    Slot& first = cache[0];
+    first.pixelFormat = pixelFormat;
+    width = height = 0;
+    frameWidth = frameHeight = 0;
+    if(!decodeFrame(0, pixelFormat, first.pixels)){
+        cache.clear();
+        return false;
+    }
+    first.state = SLOT_READY;
+
+    width = frameWidth = first.pixels.getWidth();
+    height = frameHeight = first.pixels.getHeight();
+    if(ofxThreadedVideoConvert::getScaledSize(width, height, outputWidth, outputHeight, frameWidth, frameHeight)){
+        ofPixels scaled;
+        if(ofxThreadedVideoConvert::scalePixels(first.pixels, scaled, frameWidth, frameHeight)){
+            first.pixels.swap(scaled);
+        }else{
+            // decodeFrame() leaves the rest full size too
+            ofLogError("ofxThreadedVideoImageSequencePlayer") << "openFrames(): couldn't scale " << width << "x" << height << " to " << frameWidth << "x" << frameHeight;
+            frameWidth = width;
+            frameHeight = height;
+        }
+    }
+    numFrames = paths.size();
+    frameRate = sequenceFrameRate;
+
+    numDecodedAhead = numDecodedLate = 0;
+
+    // loads run on each instance's own worker, so several can get here at once
+    ofxThreadedVideoPool::getPool().setupOnce();
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoImageSequencePlayer::readFrame(int frame){
+
+    if(frame < 0 || frame >= numFrames) return false;
+
+    unique_lock<mutex> lock(cacheMutex);
+
+    map<int, Slot>::iterator it = cache.find(frame);
+
+    // anything decoded (or being decoded) in another format is no use
+    if(it != cache.end() && it->second.pixelFormat != pixelFormat && it->second.state != SLOT_DECODING){
+        cache.erase(it);
+        it = cache.end();
+    }
+    while(it != cache.end() && it->second.state == SLOT_DECODING && it->second.pixelFormat != pixelFormat){
+        decodedCondition.wait(lock);
+        it = cache.find(frame);
+        if(it != cache.end() && it->second.state != SLOT_DECODING){
+            cache.erase(it);
+            it = cache.end();
+        }
+    }
+
+    if(it == cache.end() || it->second.state == SLOT_QUEUED){
+        // not started yet, quicker to do it here than to wait for the pool
+        Slot& slot = cache[frame];
+        slot.state = SLOT_DECODING;
+        slot.pixelFormat = pixelFormat;
+        lock.unlock();
+        ofPixels decoded;
+        bool bOk = decodeFrame(frame, pixelFormat, decoded);
+        lock.lock();
+        slot.pixels.swap(decoded);
+        slot.state = bOk ? SLOT_READY : SLOT_FAILED;
+        decodedCondition.notify_all();
+        numDecodedLate++;
+    }else{
+        if(it->second.state == SLOT_DECODING) numDecodedLate++;
+        else numDecodedAhead++;
+        while(cache[frame].state == SLOT_DECODING) decodedCondition.wait(lock);
+    }
+
+    Slot& slot = cache[frame];
+    if(slot.state != SLOT_READY){
+        cache.erase(frame);
+        return false;
+    }
+
+    if(!pixels.isAllocated() || pixels.getWidth() != frameWidth || pixels.getHeight() != frameHeight || pixels.getPixelFormat() != pixelFormat){
+        ofxThreadedVideoBufferPool& pool = ofxThreadedVideoBufferPool::getPool();
+        if(bPooledPixels) pool.release(pixels);
+        bPooledPixels = pool.acquire(pixels, frameWidth, frameHeight, pixelFormat);
+        if(!bPooledPixels) return false;
+    }
+
+    // a copy rather than pointing at the cache, so black stops etc. can't spoil cached frames
+    memcpy(pixels.getPixels(), slot.pixels.getPixels(), pixels.getTotalBytes());
+
+    lock.unlock();
+
+    queueFrames(frame);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::queueFrames(int frame){
+
+    int numQueued = 0;
+
+    {
+        ofScopedLock lock(cacheMutex);
+
+        // the frames we want next in the order we'll want them
+        int direction = getDirection();
+        set<int> window;
+        window.insert(frame);
+        pending.clear();
+        for(int i = 1; i <= readAhead && i < numFrames; i++){
+            int f = frame + i * direction;
+            if(getLoopState() == OF_LOOP_NORMAL) f = (f % numFrames + numFrames) % numFrames;
+            if(f < 0 || f >= numFrames) break;
+            window.insert(f);
+            map<int, Slot>::iterator it = cache.find(f);
+            if(it == cache.end() || (it->second.state != SLOT_DECODING && it->second.pixelFormat != pixelFormat)){
+                Slot& slot = cache[f];
+                slot.state = SLOT_QUEUED;
+                slot.pixelFormat = pixelFormat;
+                slot.pixels.clear();
+                numQueued++;
+            }
+            if(cache[f].state == SLOT_QUEUED) pending.push_back(f);
+        }
+
+        // everything else goes, apart from decodes already running (they
+        // finish into the cache and go next time round)
+        for(map<int, Slot>::iterator it = cache.begin(); it != cache.end();){
+            if(window.count(it->first) == 0 && it->second.state != SLOT_DECODING){
+                cache.erase(it++);
+            }else{
+                ++it;
+            }
+        }
+    }
+
+    ofxThreadedVideoPool& pool = ofxThreadedVideoPool::getPool();
+    for(int i = 0; i < numQueued; i++){
+        pool.submit(&decoder);
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::decodeNext(){
+
+    unique_lock<mutex> lock(cacheMutex);
+
+    while(pending.size() > 0){
+
+        int frame = pending.front();
+        pending.pop_front();
+
+        map<int, Slot>::iterator it = cache.find(frame);
+        if(it == cache.end() || it->second.state != SLOT_QUEUED) continue;
+
+        Slot& slot = it->second;
+        slot.state = SLOT_DECODING;
+        ofPixelFormat format = slot.pixelFormat;
+        lock.unlock();
+
+        ofPixels decoded;
+        bool bOk = decodeFrame(frame, format, decoded);
+
+        // decoding slots are never evicted so slot is still there
+        lock.lock();
+        slot.pixels.swap(decoded);
+        slot.state = bOk ? SLOT_READY : SLOT_FAILED;
+        decodedCondition.notify_all();
+        return;
+    }
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoImageSequencePlayer::decodeFrame(int frame, ofPixelFormat format, ofPixels& decoded){
+
+    if(!ofLoadImage(decoded, paths[frame])){
+        ofLogError("ofxThreadedVideoImageSequencePlayer") << "decodeFrame(): couldn't load " << paths[frame];
+        return false;
+    }
+
+    if(width > 0 && (decoded.getWidth() != width || decoded.getHeight() != height)){
+        ofLogError("ofxThreadedVideoImageSequencePlayer") << "decodeFrame(): " << paths[frame] << " is " << decoded.getWidth() << "x" << decoded.getHeight()
+                                                          << " but the sequence is " << width << "x" << height;
+        return false;
+    }
+
+    ofImageType imageType = format == OF_PIXELS_RGB ? OF_IMAGE_COLOR : OF_IMAGE_COLOR_ALPHA;
+    if(decoded.getImageType() != imageType) decoded.setImageType(imageType);
+    if(format == OF_PIXELS_BGRA) decoded.swapRgb();
+
+    // scaled here so it happens on the pool, in parallel with other decodes
+    if(frameWidth > 0 && (frameWidth != width || frameHeight != height)){
+        ofPixels scaled;
+        if(!ofxThreadedVideoConvert::scalePixels(decoded, scaled, frameWidth, frameHeight)) return false;
+        decoded.swap(scaled);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoImageSequencePlayer::closeFrames(){
+
+    // nothing of ours may be queued or running on the pool once we're gone
+    ofxThreadedVideoPool::getPool().remove(&decoder);
+
+    ofScopedLock lock(cacheMutex);
+    pending.clear();
+    cache.clear();
+    paths.clear();
+
+    if(bPooledPixels){
+        ofxThreadedVideoBufferPool::getPool().release(pixels);
+        bPooledPixels = false;
+    }
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoImageSequencePlayer::isPixelFormatSupported(ofPixelFormat pixelFormat) const{
+    return pixelFormat == OF_PIXELS_RGB || pixelFormat == OF_PIXELS_RGBA || pixelFormat == OF_PIXELS_BGRA;
+}
@@ -0,0 +1,141 @@
+/*
+ * ofxThreadedVideoImageSequencePlayer.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#ifndef __H_OFXTHREADEDVIDEOIMAGESEQUENCEPLAYER
+#define __H_OFXTHREADEDVIDEOIMAGESEQUENCEPLAYER
+
+#include <map>
+#include <set>
+#include <deque>
+#include <condition_variable>
+
+#include "ofMain.h"
+#include "ofxThreadedVideoFramePlayer.h"
+#include "ofxThreadedVideoPool.h"
+
+// plays a folder of numbered PNG/JPEG/TGA (or anything ofLoadImage reads)
+// frames in name order. load() takes either the folder or any one frame in
+// it, in which case only files with that frame's extension are used.
+//
+// the next setReadAhead() frames in the play direction are decoded in
+// parallel on the shared ofxThreadedVideoPool into a small cache that
+// only ever holds that window, so memory stays bounded however long the
+// sequence is. a frame that isn't ready when it's due (eg., after a seek)
+// is decoded right there rather than waiting behind queued work, so
+// setFrame() is always frame accurate and update() can't deadlock with
+// the pool even when the engine itself runs on it.
+//
+// with an output size set frames are scaled down on the pool right after
+// they're decoded, so the cache and the copies out of it shrink too
+class ofxThreadedVideoImageSequencePlayer : public ofxThreadedVideoFramePlayer, public ofxThreadedVideoOutputSize {
+
+public:
+
+    ofxThreadedVideoImageSequencePlayer();
+    ~ofxThreadedVideoImageSequencePlayer();
+
+    // sequences don't carry a frame rate, call before load() (default 30)
+    void setSequenceFrameRate(double frameRate);
+
+    void setReadAhead(int numFrames);   // default 8, 0 = decode every frame when it's due
+    int getReadAhead();
+
+    // takes effect from the next load()
+    void setOutputSize(int width, int height);
+
+    // ofxThreadedVideo makes its own players through setPlayer<T>(), so
+    // these set what every player made afterwards starts with
+    static void setDefaultSequenceFrameRate(double frameRate);
+    static void setDefaultReadAhead(int numFrames);
+
+    int getNumCached();
+    int getNumDecodedAhead();           // frames that were ready by the time they were due
+    int getNumDecodedLate();            // frames that had to be decoded when due
+
+protected:
+
+    enum SlotState {
+        SLOT_QUEUED = 0,
+        SLOT_DECODING,
+        SLOT_READY,
+        SLOT_FAILED
+    };
+
+    struct Slot {
+        SlotState state;
+        ofPixelFormat pixelFormat;
+        ofPixels pixels;
+    };
+
+    // runs one queued decode on a pool thread; it's submitted once per
+    // queued frame so several can run at the same time
+    class Decoder : public ofxThreadedVideoTask {
+    public:
+        void runTask(){ player->decodeNext(); };
+        ofxThreadedVideoImageSequencePlayer * player;
+    };
+
+    bool openFrames(const string& path);
+    bool readFrame(int frame);
+    void closeFrames();
+    bool isPixelFormatSupported(ofPixelFormat pixelFormat) const;
+
+    void decodeNext();
+    bool decodeFrame(int frame, ofPixelFormat format, ofPixels& decoded);
+    void queueFrames(int frame);
+
+    vector<string> paths;
+    double sequenceFrameRate;
+    int readAhead;
+
+    int outputWidth;
+    int outputHeight;
+    int frameWidth;     // what frames are decoded to, width x height unless scaled
+    int frameHeight;
+
+    ofMutex cacheMutex;
+    condition_variable decodedCondition;
+    map<int, Slot> cache;
+    deque<int> pending;
+    Decoder decoder;
+
+    bool bPooledPixels;
+
+    static double defaultSequenceFrameRate;
+    static int defaultReadAhead;
+
+    int numDecodedAhead;
+    int numDecodedLate;
+
+};
+
+#endif
@@ -0,0 +1,349 @@
+/*
+ * ofxThreadedVideoMetadataCache.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#include "ofxThreadedVideoMetadataCache.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef TARGET_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// native endian and layout, a cache is only ever read by the build that wrote it
+static const char ofxThreadedVideoMetadataMagic[8] = {'O', 'F', 'X', 'T', 'V', 'M', 'C', '1'};
+static const uint32_t ofxThreadedVideoMetadataVersion = 1;
+static const size_t ofxThreadedVideoMetadataHeaderSize = 16;
+
+//--------------------------------------------------------------
+static size_t ofxThreadedVideoMetadataPad(size_t numBytes){
+    return (numBytes + 7) & ~(size_t)7;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoMetadataCache& ofxThreadedVideoMetadataCache::getCache(){
+    static ofxThreadedVideoMetadataCache cache;
+    return cache;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoMetadataCache::ofxThreadedVideoMetadataCache(){
+    mappedData = NULL;
+    mappedSize = 0;
+#ifdef TARGET_WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+#else
+    fileDescriptor = -1;
+#endif
+    numHits = 0;
+    numMisses = 0;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoMetadataCache::~ofxThreadedVideoMetadataCache(){
+    close();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::open(const string& path){
+    ofScopedLock lock(mutex);
+    return openFile(path);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::openFile(const string& path){
+    
+    // callers hold the mutex
+    entries.clear();
+    unmapFile();
+    cachePath = path;
+    
+    if(!mapFile()){
+        // missing, from another version or not a cache at all - start again
+        FILE * file = fopen(cachePath.c_str(), "wb");
+        if(file != NULL){
+            unsigned char header[ofxThreadedVideoMetadataHeaderSize] = {0};
+            memcpy(header, ofxThreadedVideoMetadataMagic, sizeof(ofxThreadedVideoMetadataMagic));
+            memcpy(header + 8, &ofxThreadedVideoMetadataVersion, sizeof(ofxThreadedVideoMetadataVersion));
+            fwrite(header, 1, sizeof(header), file);
+            fclose(file);
+        }
+        if(file == NULL || !mapFile()){
+            ofLogError() << "ofxThreadedVideoMetadataCache could not open " << cachePath;
+            cachePath = "";
+            return false;
+        }
+    }
+    
+    size_t offset = ofxThreadedVideoMetadataHeaderSize;
+    while(offset + sizeof(Record) <= mappedSize){
+        
+        const Record * record = (const Record *)(mappedData + offset);
+        
+        size_t pathBytes = ofxThreadedVideoMetadataPad(record->pathLength);
+        size_t recordSize = sizeof(Record) + pathBytes + record->numFrameRuns * sizeof(ofxThreadedVideoFrameRun) + ofxThreadedVideoMetadataPad(record->numKeyframes * sizeof(int32_t));
+        if(record->recordSize != recordSize || record->pathLength == 0 || offset + recordSize > mappedSize) break;
+        
+        Entry& entry = entries[string((const char *)(mappedData + offset + sizeof(Record)), record->pathLength)];
+        entry.fileSize = record->fileSize;
+        entry.fileTime = record->fileTime;
+        entry.mapped = mappedData + offset;
+        
+        offset += recordSize;
+    }
+    
+    if(offset != mappedSize){
+        // a record was only half written when we last quit; everything
+        // before it is fine, the rest would misalign anything we append
+        ofLogWarning() << "ofxThreadedVideoMetadataCache dropping " << mappedSize - offset << " bytes of damaged records from " << cachePath;
+        entries.clear();
+        unmapFile();
+#ifdef TARGET_WIN32
+        HANDLE file = CreateFileA(cachePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(file != INVALID_HANDLE_VALUE){
+            LARGE_INTEGER size;
+            size.QuadPart = offset;
+            SetFilePointerEx(file, size, NULL, FILE_BEGIN);
+            SetEndOfFile(file);
+            CloseHandle(file);
+        }
+#else
+        if(truncate(cachePath.c_str(), offset) != 0) ofLogError() << "ofxThreadedVideoMetadataCache could not repair " << cachePath;
+#endif
+        cachePath = "";
+        return openFile(path);
+    }
+    
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoMetadataCache::close(){
+    ofScopedLock lock(mutex);
+    entries.clear();
+    unmapFile();
+    cachePath = "";
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::isOpen(){
+    ofScopedLock lock(mutex);
+    return cachePath != "";
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::lookup(const string& moviePath, ofxThreadedVideoMetadata& metadata){
+    
+    ofScopedLock lock(mutex);
+    
+    if(cachePath == "") return false;
+    
+    int64_t fileSize, fileTime;
+    map<string, Entry>::iterator it = entries.find(moviePath);
+    if(it == entries.end() || !getFileStats(moviePath, fileSize, fileTime) ||
+       it->second.fileSize != fileSize || it->second.fileTime != fileTime){
+        numMisses++;
+        return false;
+    }
+    
+    if(it->second.mapped != NULL){
+        readRecord(it->second.mapped, metadata);
+    }else{
+        metadata = it->second.metadata;
+    }
+    
+    numHits++;
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoMetadataCache::store(const string& moviePath, const ofxThreadedVideoMetadata& metadata){
+    
+    ofScopedLock lock(mutex);
+    
+    int64_t fileSize, fileTime;
+    if(cachePath == "" || moviePath == "" || !getFileStats(moviePath, fileSize, fileTime)) return;
+    
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.pathLength = moviePath.size();
+    record.fileSize = fileSize;
+    record.fileTime = fileTime;
+    record.width = metadata.width;
+    record.height = metadata.height;
+    record.numFrames = metadata.numFrames;
+    record.timeScale = metadata.timeScale;
+    record.frameRate = metadata.frameRate;
+    record.numFrameRuns = metadata.frameRuns.size();
+    record.numKeyframes = metadata.keyframeTimes.size();
+    
+    size_t pathBytes = ofxThreadedVideoMetadataPad(record.pathLength);
+    size_t runBytes = record.numFrameRuns * sizeof(ofxThreadedVideoFrameRun);
+    size_t keyframeBytes = record.numKeyframes * sizeof(int32_t);
+    record.recordSize = sizeof(Record) + pathBytes + runBytes + ofxThreadedVideoMetadataPad(keyframeBytes);
+    
+    vector<unsigned char> data(record.recordSize, 0);
+    unsigned char * p = &data[0];
+    memcpy(p, &record, sizeof(Record));
+    p += sizeof(Record);
+    memcpy(p, moviePath.c_str(), record.pathLength);
+    p += pathBytes;
+    if(runBytes > 0) memcpy(p, &metadata.frameRuns[0], runBytes);
+    p += runBytes;
+    if(keyframeBytes > 0) memcpy(p, &metadata.keyframeTimes[0], keyframeBytes);
+    
+    // one write per record so a crash leaves at most one damaged record at the end
+    FILE * file = fopen(cachePath.c_str(), "ab");
+    if(file == NULL){
+        ofLogError() << "ofxThreadedVideoMetadataCache could not write to " << cachePath;
+        return;
+    }
+    fwrite(&data[0], 1, data.size(), file);
+    fclose(file);
+    
+    Entry& entry = entries[moviePath];
+    entry.fileSize = fileSize;
+    entry.fileTime = fileTime;
+    entry.mapped = NULL;
+    entry.metadata = metadata;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoMetadataCache::getHits(){
+    ofScopedLock lock(mutex);
+    return numHits;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoMetadataCache::getMisses(){
+    ofScopedLock lock(mutex);
+    return numMisses;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoMetadataCache::getNumEntries(){
+    ofScopedLock lock(mutex);
+    return entries.size();
+}
+
+//--------------------------------------------------------------
+size_t ofxThreadedVideoMetadataCache::getMappedBytes(){
+    ofScopedLock lock(mutex);
+    return mappedSize;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::getFileStats(const string& path, int64_t& fileSize, int64_t& fileTime){
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0) return false;
+    fileSize = info.st_size;
+    fileTime = info.st_mtime;
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoMetadataCache::readRecord(const unsigned char * data, ofxThreadedVideoMetadata& metadata){
+    
+    const Record * record = (const Record *)data;
+    metadata.width = record->width;
+    metadata.height = record->height;
+    metadata.numFrames = record->numFrames;
+    metadata.timeScale = record->timeScale;
+    metadata.frameRate = record->frameRate;
+    
+    const unsigned char * p = data + sizeof(Record) + ofxThreadedVideoMetadataPad(record->pathLength);
+    const ofxThreadedVideoFrameRun * runs = (const ofxThreadedVideoFrameRun *)p;
+    metadata.frameRuns.assign(runs, runs + record->numFrameRuns);
+    
+    p += record->numFrameRuns * sizeof(ofxThreadedVideoFrameRun);
+    const int32_t * keyframes = (const int32_t *)p;
+    metadata.keyframeTimes.assign(keyframes, keyframes + record->numKeyframes);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoMetadataCache::mapFile(){
+    
+#ifdef TARGET_WIN32
+    fileHandle = CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart < ofxThreadedVideoMetadataHeaderSize){
+        unmapFile();
+        return false;
+    }
+    mappedSize = size.QuadPart;
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle != NULL) mappedData = (const unsigned char *)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+    fileDescriptor = ::open(cachePath.c_str(), O_RDONLY);
+    if(fileDescriptor == -1) return false;
+    struct stat info;
+    if(fstat(fileDescriptor, &info) != 0 || (size_t)info.st_size < ofxThreadedVideoMetadataHeaderSize){
+        unmapFile();
+        return false;
+    }
+    mappedSize = info.st_size;
+    void * data = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if(data != MAP_FAILED) mappedData = (const unsigned char *)data;
+#endif
+    
+    uint32_t version = 0;
+    if(mappedData != NULL) memcpy(&version, mappedData + 8, sizeof(version));
+    if(mappedData == NULL || memcmp(mappedData, ofxThreadedVideoMetadataMagic, sizeof(ofxThreadedVideoMetadataMagic)) != 0 ||
+       version != ofxThreadedVideoMetadataVersion){
+        unmapFile();
+        return false;
+    }
+    
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoMetadataCache::unmapFile(){
+#ifdef TARGET_WIN32
+    if(mappedData != NULL) UnmapViewOfFile(mappedData);
+    if(mappingHandle != NULL) CloseHandle(mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if(mappedData != NULL) munmap((void *)mappedData, mappedSize);
+    if(fileDescriptor != -1) ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    mappedData = NULL;
+    mappedSize = 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * ofxThreadedVideoMetadataCache.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#ifndef __H_OFXTHREADEDVIDEOMETADATACACHE
+#define __H_OFXTHREADEDVIDEOMETADATACACHE
+
+#include <map>
+#include <stdint.h>
+
+#include "ofMain.h"
+
+// a run of frames starting at time and spaced duration apart (movie time units)
+struct ofxThreadedVideoFrameRun {
+    int32_t frame;
+    int32_t time;
+    int32_t duration;
+    int32_t numFrames;
+};
+
+// what a backend learns about a movie by scanning it on load
+struct ofxThreadedVideoMetadata {
+    int width;
+    int height;
+    int numFrames;
+    int timeScale;
+    double frameRate;
+    vector<ofxThreadedVideoFrameRun> frameRuns;
+    vector<int32_t> keyframeTimes;
+};
+
+// persistent cache of ofxThreadedVideoMetadata keyed by path, file size and
+// modification time, so loads of files we've seen before can skip the scan.
+//
+// the cache is one binary file of records: it's memory mapped when opened,
+// lookups read straight from the mapping and new records are appended to
+// the end of the file (a changed file just gets a newer record, the last
+// one for a path wins). it's off until open() is called
+class ofxThreadedVideoMetadataCache {
+
+public:
+
+    ofxThreadedVideoMetadataCache();
+    ~ofxThreadedVideoMetadataCache();
+
+    static ofxThreadedVideoMetadataCache& getCache();
+
+    bool open(const string& cachePath);
+    void close();
+    bool isOpen();
+
+    // moviePath should be absolute (ie., through ofToDataPath)
+    bool lookup(const string& moviePath, ofxThreadedVideoMetadata& metadata);
+    void store(const string& moviePath, const ofxThreadedVideoMetadata& metadata);
+
+    int getHits();
+    int getMisses();
+    int getNumEntries();
+    size_t getMappedBytes();
+
+protected:
+
+    struct Record {
+        uint32_t recordSize;    // including this header and everything after it
+        uint32_t pathLength;
+        int64_t fileSize;
+        int64_t fileTime;
+        int32_t width;
+        int32_t height;
+        int32_t numFrames;
+        int32_t timeScale;
+        double frameRate;
+        uint32_t numFrameRuns;
+        uint32_t numKeyframes;
+        // then the path (padded to 8 bytes), frame runs and keyframe times
+    };
+
+    struct Entry {
+        int64_t fileSize;
+        int64_t fileTime;
+        const unsigned char * mapped;       // record in the mapping or NULL
+        ofxThreadedVideoMetadata metadata;  // when not mapped, ie., stored since open()
+    };
+
+    static bool getFileStats(const string& path, int64_t& fileSize, int64_t& fileTime);
+    static void readRecord(const unsigned char * data, ofxThreadedVideoMetadata& metadata);
+
+    bool openFile(const string& path);
+    bool mapFile();
+    void unmapFile();
+
+    ofMutex mutex;
+    string cachePath;
+    map<string, Entry> entries;
+
+    const unsigned char * mappedData;
+    size_t mappedSize;
+#ifdef TARGET_WIN32
+    void * fileHandle;
+    void * mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    int numHits;
+    int numMisses;
+
+private:
+
+    // block copy ctor and assignment operator
+    ofxThreadedVideoMetadataCache(const ofxThreadedVideoMetadataCache& other);
+    ofxThreadedVideoMetadataCache& operator=(const ofxThreadedVideoMetadataCache&);
+
+};
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ * ofxThreadedVideoPool.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#include "ofxThreadedVideoPool.h"
+
+//--------------------------------------------------------------
+void ofxThreadedVideoTask::wakeTask(){
+    ofxThreadedVideoPool::getPool().submit(this);
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoPool& ofxThreadedVideoPool::getPool(){
+    static ofxThreadedVideoPool pool;
+    return pool;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoPool::ofxThreadedVideoPool(){
+    bRunning = false;
+    defaultNumThreads = 0;
+    numPending = 0;
+    nextWorker = 0;
+    numTasksRun = 0;
+    numSteals = 0;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoPool::~ofxThreadedVideoPool(){
+    close();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::setup(int numThreads){
+
+    ofScopedLock setupLock(setupMutex);
+
+    // closing would throw away queued strands and decode tasks, and their
+    // owners would wait forever for them to run
+    if(bRunning){
+        ofLogWarning("ofxThreadedVideoPool") << "setup(): already running " << workers.size() << " threads, close() it first to resize";
+        return;
+    }
+
+    startWorkers(numThreads);
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::setupOnce(int numThreads){
+    if(bRunning) return;
+    ofScopedLock setupLock(setupMutex);
+    if(!bRunning) startWorkers(numThreads);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::setDefaultNumThreads(int numThreads){
+    defaultNumThreads = MAX(numThreads, 0);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::startWorkers(int numThreads){
+
+    if(numThreads <= 0) numThreads = defaultNumThreads;
+    if(numThreads <= 0) numThreads = thread::hardware_concurrency();
+    if(numThreads <= 0) numThreads = 4;
+
+    workers.resize(numThreads);
+    for(int i = 0; i < numThreads; i++){
+        workers[i] = new Worker;
+        workers[i]->current = NULL;
+    }
+
+    // submit() indexes workers as soon as this is set
+    bRunning = true;
+
+    // start them only once the vector is complete as they steal from each other
+    for(int i = 0; i < numThreads; i++){
+        workers[i]->workerThread = thread(&ofxThreadedVideoPool::workerFunction, this, i);
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::close(){
+
+    ofScopedLock setupLock(setupMutex);
+
+    if(!bRunning) return;
+
+    {
+        ofScopedLock lock(sleepMutex);
+        bRunning = false;
+        timers.clear();
+    }
+    sleepCondition.notify_all();
+
+    for(int i = 0; i < workers.size(); i++){
+        if(workers[i]->workerThread.joinable()) workers[i]->workerThread.join();
+    }
+    for(int i = 0; i < workers.size(); i++){
+        delete workers[i];
+    }
+    workers.clear();
+    numPending = 0;
+
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoPool::isSetup(){
+    return bRunning;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoPool::getNumThreads(){
+    return workers.size();
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::submit(ofxThreadedVideoTask * task){
+
+    if(!bRunning) return;
+
+    // keep work submitted from a pool thread on that thread (it's hot in cache)
+    // and spread everything else round robin - idle threads will steal anyway
+    int workerIndex = getCurrentWorker();
+    if(workerIndex == -1) workerIndex = nextWorker++ % workers.size();
+
+    {
+        ofScopedLock lock(workers[workerIndex]->mutex);
+        workers[workerIndex]->tasks.push_back(task);
+    }
+    numPending++;
+
+    {
+        ofScopedLock lock(sleepMutex);
+    }
+    sleepCondition.notify_one();
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::submitAfter(ofxThreadedVideoTask * task, int millis){
+
+    if(!bRunning) return;
+
+    {
+        ofScopedLock lock(sleepMutex);
+        timers.insert(make_pair(ofGetElapsedTimeMicros() + millis * 1000, task));
+    }
+    sleepCondition.notify_one();
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::remove(ofxThreadedVideoTask * task){
+
+    // a run of the task (or its timer firing) that's already under way can
+    // submit it again, so go round until it's nowhere at all
+    int self = getCurrentWorker();
+    bool bFound = true;
+    while(bFound){
+
+        bFound = false;
+
+        for(int i = 0; i < workers.size(); i++){
+            ofScopedLock lock(workers[i]->mutex);
+            deque<ofxThreadedVideoTask*>& tasks = workers[i]->tasks;
+            for(int j = 0; j < tasks.size(); j++){
+                if(tasks[j] == task){
+                    tasks.erase(tasks.begin() + j);
+                    numPending--;
+                    bFound = true;
+                    j--;
+                }
+            }
+        }
+
+        {
+            ofScopedLock lock(sleepMutex);
+            for(multimap<unsigned long long, ofxThreadedVideoTask*>::iterator it = timers.begin(); it != timers.end();){
+                if(it->second == task){
+                    timers.erase(it++);
+                    bFound = true;
+                }else{
+                    ++it;
+                }
+            }
+        }
+
+        // anything already taken has its current set, so wait for it to finish
+        for(int i = 0; i < workers.size(); i++){
+            if(i == self) continue;
+            while(workers[i]->current == task){
+                bFound = true;
+                this_thread::yield();
+            }
+        }
+
+    }
+
+}
+
+//--------------------------------------------------------------
+unsigned int ofxThreadedVideoPool::getNumTasksRun(){
+    return numTasksRun;
+}
+
+//--------------------------------------------------------------
+unsigned int ofxThreadedVideoPool::getNumSteals(){
+    return numSteals;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoPool::getCurrentWorker(){
+    thread::id threadID = this_thread::get_id();
+    for(int i = 0; i < workers.size(); i++){
+        if(workers[i]->threadID.load() == threadID) return i;
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoTask * ofxThreadedVideoPool::popTask(int workerIndex){
+
+    // own work first, newest first
+    {
+        Worker * worker = workers[workerIndex];
+        ofScopedLock lock(worker->mutex);
+        if(worker->tasks.size() > 0){
+            ofxThreadedVideoTask * task = worker->tasks.back();
+            worker->tasks.pop_back();
+            worker->current = task;
+            return task;
+        }
+    }
+
+    // then steal the oldest work from everyone else
+    for(int i = 1; i < workers.size(); i++){
+        Worker * victim = workers[(workerIndex + i) % workers.size()];
+        ofScopedLock lock(victim->mutex);
+        if(victim->tasks.size() > 0){
+            ofxThreadedVideoTask * task = victim->tasks.front();
+            victim->tasks.pop_front();
+            workers[workerIndex]->current = task;
+            numSteals++;
+            return task;
+        }
+    }
+
+    return NULL;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoPool::workerFunction(int workerIndex){
+
+    Worker * worker = workers[workerIndex];
+    worker->threadID = this_thread::get_id();
+
+    while(bRunning){
+
+        ofxThreadedVideoTask * task = popTask(workerIndex);
+
+        if(task != NULL){
+            numPending--;
+            task->runTask();
+            worker->current = NULL;
+            numTasksRun++;
+            continue;
+        }
+
+        ofScopedLock lock(sleepMutex);
+
+        // fire the next due timer, one at a time so remove() can track it
+        unsigned long long timeNow = ofGetElapsedTimeMicros();
+        if(timers.size() > 0 && timers.begin()->first <= timeNow){
+            task = timers.begin()->second;
+            timers.erase(timers.begin());
+            worker->current = task;
+            lock.unlock();
+            task->wakeTask();
+            worker->current = NULL;
+            continue;
+        }
+
+        if(!bRunning || numPending > 0) continue;
+
+        if(timers.size() > 0){
+            sleepCondition.wait_for(lock, chrono::microseconds(timers.begin()->first - timeNow));
+        }else{
+            sleepCondition.wait(lock);
+        }
+
+    }
+
+}
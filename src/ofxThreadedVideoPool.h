@@ -0,0 +1,139 @@
+/*
+ * ofxThreadedVideoPool.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#ifndef __H_OFXTHREADEDVIDEOPOOL
+#define __H_OFXTHREADEDVIDEOPOOL
+
+#include <deque>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include "ofMain.h"
+
+class ofxThreadedVideoTask {
+
+public:
+
+    virtual ~ofxThreadedVideoTask(){};
+
+    // runs on one of the pool's threads
+    virtual void runTask() = 0;
+
+    // called when a submitAfter() timer fires; by default just resubmits
+    virtual void wakeTask();
+
+};
+
+// fixed size pool of worker threads shared by every ofxThreadedVideo
+// instance that opts in with ofxThreadedVideo::setUseWorkerPool().
+//
+// each thread owns a deque of tasks: it pops its own work from the back
+// and, when that runs dry, steals from the front of the other threads'
+// deques. tasks submitted from outside the pool are spread round robin.
+class ofxThreadedVideoPool {
+
+public:
+
+    ofxThreadedVideoPool();
+    ~ofxThreadedVideoPool();
+
+    static ofxThreadedVideoPool& getPool();
+
+    // numThreads = 0 uses setDefaultNumThreads() or, if that's 0 too, one
+    // thread per core. does nothing (but warn) if the pool is already
+    // running, as closing it would drop queued tasks
+    void setup(int numThreads = 0);
+    void close();
+
+    // setup() unless it's running already, quietly: for lazy setup that
+    // can race in from any thread, eg., backends on their instance's worker
+    void setupOnce(int numThreads = 0);
+
+    // what setup(0) starts, ie., the count given to
+    // ofxThreadedVideo::setUseWorkerPool(), so whoever sets the pool up
+    // first doesn't decide its size
+    void setDefaultNumThreads(int numThreads);
+
+    bool isSetup();
+    int getNumThreads();
+
+    void submit(ofxThreadedVideoTask * task);
+    void submitAfter(ofxThreadedVideoTask * task, int millis);
+
+    // drop any queued or timed entries for task and wait until no pool
+    // thread is running it - after this it's safe to delete the task. a run
+    // already under way may resubmit it, so this keeps going until it's
+    // gone: the task has to stop resubmitting itself first (a closing flag)
+    void remove(ofxThreadedVideoTask * task);
+
+    unsigned int getNumTasksRun();
+    unsigned int getNumSteals();
+
+protected:
+
+    struct Worker {
+        ofMutex mutex;
+        deque<ofxThreadedVideoTask*> tasks;
+        thread workerThread;
+        atomic<thread::id> threadID;    // set by the thread itself, workerThread is still being assigned when it starts
+        atomic<ofxThreadedVideoTask*> current; // set while holding the lock it was taken under
+    };
+
+    void startWorkers(int numThreads);     // with setupMutex held
+    void workerFunction(int workerIndex);
+    ofxThreadedVideoTask * popTask(int workerIndex);
+    int getCurrentWorker();
+
+    vector<Worker*> workers;
+    ofMutex setupMutex;     // serialises setup() and close()
+
+    ofMutex sleepMutex;
+    condition_variable sleepCondition;
+    multimap<unsigned long long, ofxThreadedVideoTask*> timers;
+
+    atomic<bool> bRunning;
+    atomic<int> defaultNumThreads;
+    atomic<int> numPending;
+    atomic<unsigned int> nextWorker;
+    atomic<unsigned int> numTasksRun;
+    atomic<unsigned int> numSteals;
+
+private:
+
+    // block copy ctor and assignment operator
+    ofxThreadedVideoPool(const ofxThreadedVideoPool& other);
+    ofxThreadedVideoPool& operator=(const ofxThreadedVideoPool&);
+
+};
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ * ofxThreadedVideoQuickTimePlayer.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+#ifndef __H_OFXTHREADEDVIDEOQUICKTIMEPLAYER
+#define __H_OFXTHREADEDVIDEOQUICKTIMEPLAYER
+
+#include "ofMain.h"
+#include "ofxThreadedVideoBufferPool.h"
+#include "ofxThreadedVideoMetadataCache.h"
+#include "ofxThreadedVideoFramePlayer.h"
+#include "ofxThreadedVideoConvert.h"
+
+// the QuickTime backend needs the 32-bit QuickTime APIs, which only exist
+// on 32-bit OSX and Windows builds; everywhere else ofxThreadedVideo falls
+// back to the platform's own player (or whatever is set with setPlayer<T>)
+#ifndef OFX_THREADED_VIDEO_USE_QUICKTIME
+#if (defined(TARGET_OSX) || defined(TARGET_WIN32)) && !__LP64__ && !defined(_WIN64)
+#define OFX_THREADED_VIDEO_USE_QUICKTIME 1
+#else
+#define OFX_THREADED_VIDEO_USE_QUICKTIME 0
+#endif
+#endif
+
+#if OFX_THREADED_VIDEO_USE_QUICKTIME
+
+#include "ofQtUtils.h"
+#include "ofQuickTimePlayer.h"
+
+// class implimentation overrides how ofQuicktimePlayer implements pixel
+// decoding and allows setPixels for RGB, RGBA, BGRA and YUY2 pixel formats.
+// with an output size set the movie box is shrunk so QuickTime decodes
+// straight into the smaller gworld
+class ofQuickTimePlayerWithFastPixels: public ofQuickTimePlayer, public ofxThreadedVideoOutputSize{
+    
+public:
+    
+ofQuickTimePlayerWithFastPixels(){
+    pooledPixels = NULL;
+    offscreenGWorldPixels = NULL;
+    outputWidth = outputHeight = 0;
+    naturalWidth = naturalHeight = 0;
+}
+    
+void setOutputSize(int _width, int _height){
+    outputWidth = MAX(_width, 0);
+    outputHeight = MAX(_height, 0);
+}
+    
+// the movie's own size, whatever the gworld is
+float getWidth() const{
+    return naturalWidth > 0 ? naturalWidth : width;
+}
+    
+float getHeight() const{
+    return naturalHeight > 0 ? naturalHeight : height;
+}
+    
+bool load(string name){
+    // remember what we're opening for the metadata cache
+    if(name.substr(0, 7) == "http://" || name.substr(0, 7) == "rtsp://"){
+        metadataPath = "";
+    }else{
+        metadataPath = ofToDataPath(name, true);
+    }
+    return ofQuickTimePlayer::load(name);
+}
+    
+~ofQuickTimePlayerWithFastPixels(){
+    // the movie and gworld have to let go of the buffer before it goes
+    // back to the pool and gets handed to another player
+    closeMovie();
+    if(offscreenGWorld) DisposeGWorld(offscreenGWorld);
+    offscreenGWorld = NULL;
+    releasePixels();
+}
+    
+void createImgMemAndGWorld(){
+    
+    // width and height are the movie box here, fresh from each load
+    naturalWidth = width;
+    naturalHeight = height;
+    
+    Rect movieRect;
+    movieRect.top 			= 0;
+    movieRect.left 			= 0;
+    
+    int scaledWidth, scaledHeight;
+    if(ofxThreadedVideoConvert::getScaledSize(width, height, outputWidth, outputHeight, scaledWidth, scaledHeight)){
+        width = scaledWidth;
+        height = scaledHeight;
+        movieRect.bottom = height;
+        movieRect.right = width;
+        SetMovieBox(moviePtr, &(movieRect));
+    }
+    
+    movieRect.bottom 		= height;
+    movieRect.right 		= width;
+    
+    // quicktime draws straight into pixels, which borrow a buffer from the
+    // shared pool - so there's no offscreenGWorldPixels, and reloading a
+    // clip of a size we've seen before doesn't allocate anything
+    switch(internalPixelFormat){
+            
+        case OF_PIXELS_RGB:
+        {
+            if(!acquirePixels(OF_PIXELS_RGB, 3 * width * height)) break;
+            QTNewGWorldFromPtr (&(offscreenGWorld), k24RGBPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 3 * width);
+            break;
+        }
+        case OF_PIXELS_RGBA:
+        {
+            if(!acquirePixels(OF_PIXELS_RGBA, 4 * width * height)) break;
+            QTNewGWorldFromPtr (&(offscreenGWorld), k32RGBAPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
+            break;
+        }
+        case OF_PIXELS_BGRA:
+        {
+            if(!acquirePixels(OF_PIXELS_BGRA, 4 * width * height)) break;
+            QTNewGWorldFromPtr (&(offscreenGWorld), k32BGRAPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
+            break;
+        }
+        case OF_PIXELS_YUY2:
+        {
+#if !defined (TARGET_OSX) && !defined (GL_APPLE_rgb_422)
+            movieRect.right = width*2; // this makes it look correct but we lose some of the performance gains
+            SetMovieBox(moviePtr, &(movieRect));
+            //width = width / 2; // this makes it go really fast but we only get 'half-resolution'...
+            if(!acquirePixels(OF_PIXELS_RGBA, 4 * width * height)) break;
+            QTNewGWorldFromPtr (&(offscreenGWorld), k24RGBPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 4 * width);
+#else
+            
+            // for some reason doesn't like non-even width's and height's
+            if(width % 2 != 0) width++;
+            if(height % 2 != 0) height++;
+            movieRect.bottom = height;
+            movieRect.right = width;
+            
+            // this works perfectly on Mac platform!
+            if(!acquirePixels(OF_PIXELS_YUY2, 2 * width * height)) break;
+            QTNewGWorldFromPtr (&(offscreenGWorld), k2vuyPixelFormat, &(movieRect), NULL, NULL, 0, (pixels.getPixels()), 2 * width);
+#endif
+            
+            break;
+        }
+    }
+    
+    if(pooledPixels == NULL){
+        // ofQuickTimePlayer::load() gives up when it finds no movie here,
+        // and with no size the next load won't reuse a gworld we never made
+        DisposeMovie(moviePtr);
+        moviePtr = NULL;
+        offscreenGWorld = NULL;
+        width = height = 0;
+        return;
+    }
+    
+    LockPixels(GetGWorldPixMap(offscreenGWorld));
+    
+    // from : https://github.com/openframeworks/openFrameworks/issues/244
+    // SetGWorld do not seems to be necessary for offscreen rendering of the movie
+    // only SetMovieGWorld should be called
+    // if both are called, the app will crash after a few ofVideoPlayer object have been deleted
+    
+#ifndef TARGET_WIN32
+    SetGWorld (offscreenGWorld, NULL);
+#endif
+    SetMovieGWorld (moviePtr, offscreenGWorld, nil);
+    
+}
+    
+//---------------------------------------------------------------------------
+bool setPixelFormat(ofPixelFormat pixelFormat){
+    //note as we only support RGB we are just confirming that this pixel format is supported
+    if( pixelFormat == OF_PIXELS_RGB || pixelFormat == OF_PIXELS_RGBA || pixelFormat == OF_PIXELS_BGRA || pixelFormat == OF_PIXELS_YUY2){
+        internalPixelFormat = pixelFormat;
+        return true;
+    }
+    ofLogWarning("ofQuickTimePlayer") << "setPixelFormat(): requested pixel format " << pixelFormat << " not supported";
+    return false;
+}
+    
+protected:
+    
+void buildFrameIndex(){
+    
+    ofxThreadedVideoMetadataCache& cache = ofxThreadedVideoMetadataCache::getCache();
+    ofxThreadedVideoMetadata metadata;
+    
+    if(metadataPath != "" && cache.lookup(metadataPath, metadata)){
+        // seen this file before, no need to walk every sample again
+        nFrames = metadata.numFrames;
+        frameIndex.resize(metadata.frameRuns.size());
+        for(int i = 0; i < metadata.frameRuns.size(); i++){
+            frameIndex[i].frame = metadata.frameRuns[i].frame;
+            frameIndex[i].time = metadata.frameRuns[i].time;
+            frameIndex[i].duration = metadata.frameRuns[i].duration;
+            frameIndex[i].numFrames = metadata.frameRuns[i].numFrames;
+        }
+        return;
+    }
+    
+    ofQuickTimePlayer::buildFrameIndex();
+    
+    if(metadataPath == "" || !cache.isOpen()) return;
+    
+    metadata.width = width;
+    metadata.height = height;
+    metadata.numFrames = nFrames;
+    metadata.timeScale = GetMovieTimeScale(moviePtr);
+    metadata.frameRate = 0;
+    MovieGetStaticFrameRate(moviePtr, &metadata.frameRate);
+    
+    metadata.frameRuns.resize(frameIndex.size());
+    for(int i = 0; i < frameIndex.size(); i++){
+        metadata.frameRuns[i].frame = frameIndex[i].frame;
+        metadata.frameRuns[i].time = frameIndex[i].time;
+        metadata.frameRuns[i].duration = frameIndex[i].duration;
+        metadata.frameRuns[i].numFrames = frameIndex[i].numFrames;
+    }
+    
+    // sync samples only, so this is a much shorter walk than the frame count
+    TimeValue keyframeTime = 0;
+    OSType whichMediaType = FOUR_CHAR_CODE('vide');
+    short flags = nextTimeSyncSample + nextTimeEdgeOK;
+    while(keyframeTime >= 0){
+        GetMovieNextInterestingTime(moviePtr, flags, 1, &whichMediaType, keyframeTime, 0, &keyframeTime, NULL);
+        if(keyframeTime >= 0) metadata.keyframeTimes.push_back(keyframeTime);
+        flags = nextTimeSyncSample;
+    }
+    
+    cache.store(metadataPath, metadata);
+}
+    
+bool acquirePixels(ofPixelFormat pixelFormat, int numBytes){
+    // ofQuickTimePlayer has already disposed of the old gworld by the time
+    // it calls createImgMemAndGWorld(), so the old buffer can go back now
+    releasePixels();
+    pooledPixels = ofxThreadedVideoBufferPool::getPool().acquire(width, height, pixelFormat, numBytes);
+    if(pooledPixels == NULL){
+        ofLogError("ofQuickTimePlayer") << "createImgMemAndGWorld(): couldn't get a " << width << "x" << height << " buffer, giving up on the load";
+        return false;
+    }
+    pixels.setFromExternalPixels(pooledPixels, width, height, pixelFormat);
+    return true;
+}
+    
+void releasePixels(){
+    if(pooledPixels == NULL) return;
+    pixels.clear();
+    ofxThreadedVideoBufferPool::getPool().release(pooledPixels);
+    pooledPixels = NULL;
+}
+    
+    int internalPixelFormat;
+    unsigned char * pooledPixels;
+    string metadataPath;
+    
+    int outputWidth;
+    int outputHeight;
+    int naturalWidth;
+    int naturalHeight;
+    
+};
+
+#endif
+
+#endif
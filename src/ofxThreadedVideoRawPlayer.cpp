@@ -0,0 +1,378 @@
+/*
+ * ofxThreadedVideoRawPlayer.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#include "ofxThreadedVideoRawPlayer.h"
+#include "ofxThreadedVideoBufferPool.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef TARGET_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char ofxThreadedVideoRawMagic[8] = {'O', 'F', 'X', 'T', 'V', 'R', 'A', 'W'};
+static const uint32_t ofxThreadedVideoRawVersion = 1;
+
+// frames start page aligned and stay aligned for SIMD from one to the next
+static const uint32_t ofxThreadedVideoRawHeaderSize = 4096;
+
+//--------------------------------------------------------------
+ofxThreadedVideoRawPlayer::ofxThreadedVideoRawPlayer(){
+    mappedData = NULL;
+    mappedSize = 0;
+#ifdef TARGET_WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = NULL;
+#else
+    fileDescriptor = -1;
+#endif
+    memset(&header, 0, sizeof(header));
+    lastFrame = -1;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoRawPlayer::~ofxThreadedVideoRawPlayer(){
+    close();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawPlayer::openFrames(const string& path){
+
+    if(!mapFile(path)) return false;
+
+    memcpy(&header, mappedData, sizeof(header));
+
+    ofPixelFormat filePixelFormat;
+    if(memcmp(header.magic, ofxThreadedVideoRawMagic, sizeof(ofxThreadedVideoRawMagic)) != 0 || header.version != ofxThreadedVideoRawVersion ||
+       header.headerSize < sizeof(header) || !getPixelFormat(header.pixelFormat, filePixelFormat)){
+        ofLogError("ofxThreadedVideoRawPlayer") << "openFrames(): " << path << " isn't a raw frame file (or is from another version)";
+        return false;
+    }
+
+    if(filePixelFormat != pixelFormat){
+        ofLogError("ofxThreadedVideoRawPlayer") << "openFrames(): " << path << " holds " << string(header.pixelFormat, 4)
+                                                << " frames, call setPixelFormat() to match before loading";
+        return false;
+    }
+
+    size_t frameSize = ofPixels::bytesFromPixelFormat(header.width, header.height, filePixelFormat);
+    if(header.width <= 0 || header.height <= 0 || header.frameStride < frameSize){
+        ofLogError("ofxThreadedVideoRawPlayer") << "openFrames(): " << path << " has a bad header";
+        return false;
+    }
+
+    // only count frames that are all there
+    uint64_t numComplete = mappedSize < header.headerSize + frameSize ? 0 : (mappedSize - header.headerSize - frameSize) / header.frameStride + 1;
+
+    width = header.width;
+    height = header.height;
+    numFrames = MIN((uint64_t)header.numFrames, numComplete);
+    frameRate = header.frameRateDen > 0 ? (double)header.frameRateNum / header.frameRateDen : 0;
+    lastFrame = -1;
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawPlayer::readFrame(int frame){
+
+    if(mappedData == NULL || frame < 0 || frame >= numFrames) return false;
+
+    pixels.setFromExternalPixels(mappedData + header.headerSize + frame * header.frameStride, width, height, pixelFormat);
+
+    int direction = getDirection();
+    if(lastFrame == -1 || frame != lastFrame + direction){
+        // jumped: page in the whole window from here
+        readAhead(frame + direction, OFX_THREADED_VIDEO_RAW_READ_AHEAD, direction);
+    }else{
+        // moved on by one: the window only gains its far end
+        readAhead(frame + direction * OFX_THREADED_VIDEO_RAW_READ_AHEAD, 1, direction);
+    }
+    lastFrame = frame;
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoRawPlayer::directionChanged(int direction){
+    if(lastFrame != -1) readAhead(lastFrame + direction, OFX_THREADED_VIDEO_RAW_READ_AHEAD, direction);
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoRawPlayer::readAhead(int frame, int count, int direction){
+
+#ifndef TARGET_WIN32
+    // looping plays run off either end back onto the other
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    int first = direction > 0 ? frame : frame - count + 1;
+    for(int i = 0; i < count; i++){
+        int f = first + i;
+        if(getLoopState() == OF_LOOP_NORMAL) f = (f % numFrames + numFrames) % numFrames;
+        if(f < 0 || f >= numFrames) continue;
+        // madvise wants page aligned addresses
+        size_t start = header.headerSize + f * header.frameStride;
+        size_t end = MIN(start + (size_t)header.frameStride, mappedSize);
+        size_t alignedStart = start & ~(pageSize - 1);
+        madvise(mappedData + alignedStart, end - alignedStart, MADV_WILLNEED);
+    }
+#endif
+    // windows has no cheap equivalent before 8 (PrefetchVirtualMemory), so
+    // there its own read ahead has to do
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoRawPlayer::closeFrames(){
+    // pixels only point into the mapping
+    pixels.clear();
+    unmapFile();
+    memset(&header, 0, sizeof(header));
+    lastFrame = -1;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawPlayer::isPixelFormatSupported(ofPixelFormat pixelFormat) const{
+    char fourCC[4];
+    return ofxThreadedVideoRawWriter::getFourCC(pixelFormat, fourCC);
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawPlayer::mapFile(const string& path){
+
+    unmapFile();
+
+#ifdef TARGET_WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE){
+        ofLogError("ofxThreadedVideoRawPlayer") << "mapFile(): couldn't open " << path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart < sizeof(header) || (uint64_t)size.QuadPart > (size_t)-1){
+        ofLogError("ofxThreadedVideoRawPlayer") << "mapFile(): " << path << " is too small or too big to map";
+        unmapFile();
+        return false;
+    }
+    mappedSize = size.QuadPart;
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if(mappingHandle != NULL) mappedData = (unsigned char *)MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+#else
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if(fileDescriptor == -1){
+        ofLogError("ofxThreadedVideoRawPlayer") << "mapFile(): couldn't open " << path;
+        return false;
+    }
+    struct stat info;
+    if(fstat(fileDescriptor, &info) != 0 || (size_t)info.st_size < sizeof(header) || (uint64_t)info.st_size > (size_t)-1){
+        ofLogError("ofxThreadedVideoRawPlayer") << "mapFile(): " << path << " is too small or too big to map";
+        unmapFile();
+        return false;
+    }
+    mappedSize = info.st_size;
+    void * data = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+    if(data != MAP_FAILED){
+        mappedData = (unsigned char *)data;
+        // we do our own read ahead in the play direction
+        madvise(mappedData, mappedSize, MADV_RANDOM);
+    }
+#endif
+
+    if(mappedData == NULL){
+        ofLogError("ofxThreadedVideoRawPlayer") << "mapFile(): couldn't map " << path;
+        unmapFile();
+        return false;
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoRawPlayer::unmapFile(){
+#ifdef TARGET_WIN32
+    if(mappedData != NULL) UnmapViewOfFile(mappedData);
+    if(mappingHandle != NULL) CloseHandle(mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if(mappedData != NULL) munmap(mappedData, mappedSize);
+    if(fileDescriptor != -1) ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    mappedData = NULL;
+    mappedSize = 0;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawPlayer::getPixelFormat(const char fourCC[4], ofPixelFormat& pixelFormat){
+    const ofPixelFormat pixelFormats[] = {OF_PIXELS_RGB, OF_PIXELS_RGBA, OF_PIXELS_BGRA, OF_PIXELS_YUY2, OF_PIXELS_I420, OF_PIXELS_NV12};
+    for(int i = 0; i < 6; i++){
+        char candidate[4];
+        ofxThreadedVideoRawWriter::getFourCC(pixelFormats[i], candidate);
+        if(memcmp(candidate, fourCC, 4) == 0){
+            pixelFormat = pixelFormats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoRawWriter::ofxThreadedVideoRawWriter(){
+    file = NULL;
+    frameSize = 0;
+    memset(&header, 0, sizeof(header));
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoRawWriter::~ofxThreadedVideoRawWriter(){
+    close();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawWriter::open(const string& path, int width, int height, ofPixelFormat pixelFormat, double frameRate){
+
+    close();
+
+    memset(&header, 0, sizeof(header));
+    if(width <= 0 || height <= 0 || !getFourCC(pixelFormat, header.pixelFormat)){
+        ofLogError("ofxThreadedVideoRawWriter") << "open(): can only write RGB, RGBA, BGRA, YUY2, I420 or NV12 frames";
+        return false;
+    }
+
+    file = fopen(ofToDataPath(path, true).c_str(), "wb");
+    if(file == NULL){
+        ofLogError("ofxThreadedVideoRawWriter") << "open(): couldn't create " << path;
+        return false;
+    }
+
+    frameSize = ofPixels::bytesFromPixelFormat(width, height, pixelFormat);
+
+    memcpy(header.magic, ofxThreadedVideoRawMagic, sizeof(ofxThreadedVideoRawMagic));
+    header.version = ofxThreadedVideoRawVersion;
+    header.headerSize = ofxThreadedVideoRawHeaderSize;
+    header.width = width;
+    header.height = height;
+    header.frameRateNum = (uint32_t)(frameRate * 1000 + 0.5);
+    header.frameRateDen = 1000;
+    header.numFrames = 0;
+    header.frameStride = (frameSize + OFX_THREADED_VIDEO_BUFFER_ALIGNMENT - 1) & ~(uint64_t)(OFX_THREADED_VIDEO_BUFFER_ALIGNMENT - 1);
+
+    padding.assign(ofxThreadedVideoRawHeaderSize, 0);
+    memcpy(&padding[0], &header, sizeof(header));
+    if(fwrite(&padding[0], 1, padding.size(), file) != padding.size()){
+        ofLogError("ofxThreadedVideoRawWriter") << "open(): couldn't write to " << path;
+        fclose(file);
+        file = NULL;
+        return false;
+    }
+    padding.assign(header.frameStride - frameSize, 0);
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawWriter::addFrame(const ofPixels& pixels){
+
+    if(file == NULL) return false;
+
+    char fourCC[4];
+    if(pixels.getWidth() != header.width || pixels.getHeight() != header.height ||
+       !getFourCC(pixels.getPixelFormat(), fourCC) || memcmp(fourCC, header.pixelFormat, 4) != 0){
+        ofLogError("ofxThreadedVideoRawWriter") << "addFrame(): frame doesn't match the size or format the file was opened with";
+        return false;
+    }
+
+    if(fwrite(pixels.getPixels(), 1, frameSize, file) != frameSize ||
+       (padding.size() > 0 && fwrite(&padding[0], 1, padding.size(), file) != padding.size())){
+        ofLogError("ofxThreadedVideoRawWriter") << "addFrame(): write failed";
+        return false;
+    }
+
+    header.numFrames++;
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawWriter::close(){
+
+    if(file == NULL) return false;
+
+    // now we know how many frames there are
+    bool bOk = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, 1, sizeof(header), file) == sizeof(header);
+    bOk = fclose(file) == 0 && bOk;
+    file = NULL;
+
+    if(!bOk) ofLogError("ofxThreadedVideoRawWriter") << "close(): couldn't finish the file";
+    return bOk;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawWriter::isOpen(){
+    return file != NULL;
+}
+
+//--------------------------------------------------------------
+int ofxThreadedVideoRawWriter::getNumFrames(){
+    return header.numFrames;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoRawWriter::getFourCC(ofPixelFormat pixelFormat, char fourCC[4]){
+    switch(pixelFormat){
+        case OF_PIXELS_RGB:
+            memcpy(fourCC, "RGB ", 4);
+            return true;
+        case OF_PIXELS_RGBA:
+            memcpy(fourCC, "RGBA", 4);
+            return true;
+        case OF_PIXELS_BGRA:
+            memcpy(fourCC, "BGRA", 4);
+            return true;
+        case OF_PIXELS_YUY2:
+            memcpy(fourCC, "2vuy", 4);
+            return true;
+        case OF_PIXELS_I420:
+            memcpy(fourCC, "I420", 4);
+            return true;
+        case OF_PIXELS_NV12:
+            memcpy(fourCC, "NV12", 4);
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * ofxThreadedVideoRawPlayer.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#ifndef __H_OFXTHREADEDVIDEORAWPLAYER
+#define __H_OFXTHREADEDVIDEORAWPLAYER
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ofMain.h"
+#include "ofxThreadedVideoFramePlayer.h"
+
+// how many frames ahead of the play head the raw player asks the OS to page in
+#ifndef OFX_THREADED_VIDEO_RAW_READ_AHEAD
+#define OFX_THREADED_VIDEO_RAW_READ_AHEAD 8
+#endif
+
+// a raw frame file is a small header followed by numFrames frames of
+// uncompressed pixels, frameStride bytes apart, ready to upload as they are.
+// everything is native endian, like the metadata cache
+struct ofxThreadedVideoRawHeader {
+    char magic[8];              // "OFXTVRAW"
+    uint32_t version;
+    uint32_t headerSize;        // where the first frame starts
+    int32_t width;
+    int32_t height;
+    char pixelFormat[4];        // "RGB ", "RGBA", "BGRA", "2vuy" (YUY2 as the engine uploads it), "I420" or "NV12"
+    uint32_t frameRateNum;
+    uint32_t frameRateDen;
+    uint32_t numFrames;
+    uint64_t frameStride;
+};
+
+// plays raw frame files without decoding anything: the file is memory
+// mapped and getPixels() points straight at the current frame in the
+// mapping, so the only copy is the one the engine makes into its texture
+// or decode ahead ring. pages for the next frames in the play direction are
+// requested with madvise() as playback moves.
+//
+// the mapping is private copy on write, so writes to the pixels (eg., black
+// stops) never reach the file. files play in the format they were written
+// in; load() fails if that isn't the format set with setPixelFormat().
+// 32 bit builds can only map files that fit in their address space
+class ofxThreadedVideoRawPlayer : public ofxThreadedVideoFramePlayer {
+
+public:
+
+    ofxThreadedVideoRawPlayer();
+    ~ofxThreadedVideoRawPlayer();
+
+protected:
+
+    bool openFrames(const string& path);
+    bool readFrame(int frame);
+    void closeFrames();
+    bool isPixelFormatSupported(ofPixelFormat pixelFormat) const;
+    void directionChanged(int direction);
+
+    bool mapFile(const string& path);
+    void unmapFile();
+    void readAhead(int frame, int numFrames, int direction);
+
+    static bool getPixelFormat(const char fourCC[4], ofPixelFormat& pixelFormat);
+    unsigned char * mappedData;
+    size_t mappedSize;
+#ifdef TARGET_WIN32
+    void * fileHandle;
+    void * mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+    ofxThreadedVideoRawHeader header;
+    int lastFrame;
+
+};
+
+// writes raw frame files for ofxThreadedVideoRawPlayer, eg., by stepping
+// through a clip with any other player and adding its pixels frame by frame
+class ofxThreadedVideoRawWriter {
+
+public:
+
+    ofxThreadedVideoRawWriter();
+    ~ofxThreadedVideoRawWriter();
+
+    bool open(const string& path, int width, int height, ofPixelFormat pixelFormat, double frameRate);
+    bool addFrame(const ofPixels& pixels);
+    bool close();
+
+    bool isOpen();
+    int getNumFrames();
+
+    static bool getFourCC(ofPixelFormat pixelFormat, char fourCC[4]);
+
+protected:
+
+    FILE * file;
+    ofxThreadedVideoRawHeader header;
+    size_t frameSize;
+    vector<unsigned char> padding;
+
+private:
+
+    // block copy ctor and assignment operator
+    ofxThreadedVideoRawWriter(const ofxThreadedVideoRawWriter& other);
+    ofxThreadedVideoRawWriter& operator=(const ofxThreadedVideoRawWriter&);
+
+};
+
+#endif
@@ -0,0 +1,358 @@
+/*
+ * ofxThreadedVideoY4MPlayer.cpp
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#include "ofxThreadedVideoY4MPlayer.h"
+#include "ofxThreadedVideoBufferPool.h"
+#include "ofxThreadedVideoConvert.h"
+
+static const string ofxThreadedVideoY4MMagic = "YUV4MPEG2 ";
+static const string ofxThreadedVideoY4MFrameMagic = "FRAME";
+static const int ofxThreadedVideoY4MMaxHeader = 4096;
+
+//--------------------------------------------------------------
+static bool ofxThreadedVideoY4MReadLine(FILE * file, string& line){
+    line.clear();
+    int c;
+    while((c = fgetc(file)) != EOF){
+        if(c == '\n') return true;
+        if(line.size() >= ofxThreadedVideoY4MMaxHeader) return false;
+        line += (char)c;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoY4MPlayer::ofxThreadedVideoY4MPlayer(){
+    file = NULL;
+    chromaType = CHROMA_420;
+    chromaWidth = chromaHeight = 0;
+    frameSize = 0;
+    bPooledPixels = false;
+}
+
+//--------------------------------------------------------------
+ofxThreadedVideoY4MPlayer::~ofxThreadedVideoY4MPlayer(){
+    close();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::openFrames(const string& path){
+
+    file = fopen(path.c_str(), "rb");
+    if(file == NULL){
+        ofLogError("ofxThreadedVideoY4MPlayer") << "openFrames(): couldn't open " << path;
+        return false;
+    }
+
+    if(!readHeader(path)) return false;
+
+    // ofPixels' planar layouts only cover even sizes
+    if((pixelFormat == OF_PIXELS_I420 || pixelFormat == OF_PIXELS_NV12) && (width % 2 != 0 || height % 2 != 0)){
+        ofLogError("ofxThreadedVideoY4MPlayer") << "openFrames(): I420 and NV12 need an even width and height, " << path << " is " << width << "x" << height;
+        return false;
+    }
+
+    switch(chromaType){
+        case CHROMA_420:
+            chromaWidth = (width + 1) / 2;
+            chromaHeight = (height + 1) / 2;
+            break;
+        case CHROMA_422:
+            chromaWidth = (width + 1) / 2;
+            chromaHeight = height;
+            break;
+        case CHROMA_444:
+            chromaWidth = width;
+            chromaHeight = height;
+            break;
+        case CHROMA_MONO:
+            chromaWidth = width;
+            chromaHeight = height;
+            neutralChroma.assign((size_t)width * height, 128);
+            break;
+    }
+
+    frameSize = (size_t)width * height;
+    if(chromaType != CHROMA_MONO) frameSize += 2 * (size_t)chromaWidth * chromaHeight;
+    frameData.resize(frameSize);
+
+    if(!indexFrames()) return false;
+
+    numFrames = frameOffsets.size();
+
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::readHeader(const string& path){
+
+    string header;
+    if(!ofxThreadedVideoY4MReadLine(file, header) || header.compare(0, ofxThreadedVideoY4MMagic.size(), ofxThreadedVideoY4MMagic) != 0){
+        ofLogError("ofxThreadedVideoY4MPlayer") << "readHeader(): " << path << " isn't a YUV4MPEG2 stream";
+        return false;
+    }
+
+    chromaType = CHROMA_420;
+
+    vector<string> tokens = ofSplitString(header.substr(ofxThreadedVideoY4MMagic.size()), " ", true, true);
+    for(int i = 0; i < tokens.size(); i++){
+        const string& token = tokens[i];
+        string value = token.substr(1);
+        switch(token[0]){
+            case 'W':
+                width = ofToInt(value);
+                break;
+            case 'H':
+                height = ofToInt(value);
+                break;
+            case 'F':
+            {
+                vector<string> rate = ofSplitString(value, ":");
+                if(rate.size() == 2 && ofToInt(rate[1]) > 0) frameRate = ofToDouble(rate[0]) / ofToDouble(rate[1]);
+                break;
+            }
+            case 'C':
+            {
+                if(value == "420" || value == "420jpeg" || value == "420paldv" || value == "420mpeg2"){
+                    chromaType = CHROMA_420;
+                }else if(value == "422"){
+                    chromaType = CHROMA_422;
+                }else if(value == "444"){
+                    chromaType = CHROMA_444;
+                }else if(value == "mono"){
+                    chromaType = CHROMA_MONO;
+                }else{
+                    ofLogError("ofxThreadedVideoY4MPlayer") << "readHeader(): colorspace C" << value << " not supported (8 bit 420, 422, 444 and mono only)";
+                    return false;
+                }
+                break;
+            }
+            default:
+                // interlacing, aspect and X tags don't change how we read frames
+                break;
+        }
+    }
+
+    return width > 0 && height > 0;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::indexFrames(){
+
+    // frame headers can carry their own parameters so they aren't all the
+    // same length; walking them once makes every later seek a single fseek
+    frameOffsets.clear();
+
+    int64_t headerEnd = tellFile();
+    if(!seekFile(-1)) return false;
+    int64_t fileSize = tellFile();
+    seekFile(headerEnd);
+
+    string frameHeader;
+    while(ofxThreadedVideoY4MReadLine(file, frameHeader)){
+        if(frameHeader.compare(0, ofxThreadedVideoY4MFrameMagic.size(), ofxThreadedVideoY4MFrameMagic) != 0){
+            ofLogWarning("ofxThreadedVideoY4MPlayer") << "indexFrames(): lost sync after frame " << frameOffsets.size() << ", ignoring the rest";
+            break;
+        }
+        int64_t offset = tellFile();
+        // a truncated last frame doesn't count
+        if(offset + (int64_t)frameSize > fileSize) break;
+        frameOffsets.push_back(offset);
+        if(!seekFile(offset + frameSize)) break;
+    }
+
+    return frameOffsets.size() > 0;
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::seekFile(int64_t offset){
+    // -1 for the end of the file
+#ifdef TARGET_WIN32
+    return _fseeki64(file, offset < 0 ? 0 : offset, offset < 0 ? SEEK_END : SEEK_SET) == 0;
+#else
+    return fseeko(file, offset < 0 ? 0 : offset, offset < 0 ? SEEK_END : SEEK_SET) == 0;
+#endif
+}
+
+//--------------------------------------------------------------
+int64_t ofxThreadedVideoY4MPlayer::tellFile(){
+#ifdef TARGET_WIN32
+    return _ftelli64(file);
+#else
+    return ftello(file);
+#endif
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::readFrame(int frame){
+
+    if(file == NULL || frame < 0 || frame >= frameOffsets.size()) return false;
+
+    if(!seekFile(frameOffsets[frame]) || fread(&frameData[0], 1, frameSize, file) != frameSize){
+        ofLogError("ofxThreadedVideoY4MPlayer") << "readFrame(): couldn't read frame " << frame;
+        return false;
+    }
+
+    if(!pixels.isAllocated() || pixels.getWidth() != width || pixels.getHeight() != height || pixels.getPixelFormat() != pixelFormat){
+        ofxThreadedVideoBufferPool& pool = ofxThreadedVideoBufferPool::getPool();
+        if(bPooledPixels) pool.release(pixels);
+        bPooledPixels = pool.acquire(pixels, width, height, pixelFormat);
+        if(!bPooledPixels) return false;
+    }
+
+    const unsigned char * y = &frameData[0];
+    const unsigned char * u = y + (size_t)width * height;
+    const unsigned char * v = u + (size_t)chromaWidth * chromaHeight;
+    if(chromaType == CHROMA_MONO) u = v = &neutralChroma[0];
+
+    if(pixelFormat == OF_PIXELS_YUY2){
+        convertToYUY2(y, u, v, pixels.getPixels());
+    }else if(pixelFormat == OF_PIXELS_I420 || pixelFormat == OF_PIXELS_NV12){
+        convertToPlanar(y, u, v);
+    }else{
+        convertToRGB(y, u, v);
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoY4MPlayer::convertToRGB(const unsigned char * y, const unsigned char * u, const unsigned char * v){
+
+    int dstStride = width * pixels.getNumChannels();
+
+    // even 4:2:0 frames go straight through the shared planar kernels,
+    // everything else is interleaved to 2vuy first like a YUY2 frame
+    if(chromaType == CHROMA_420 && width % 2 == 0 && height % 2 == 0){
+        ofxThreadedVideoConvert::planarToPixels(y, width, u, v, chromaWidth, pixels.getPixels(), dstStride, width, height, pixelFormat);
+        return;
+    }
+
+    yuy2Data.resize((size_t)width * height * 2);
+    convertToYUY2(y, u, v, &yuy2Data[0]);
+    ofxThreadedVideoConvert::yuy2ToPixels(&yuy2Data[0], width * 2, pixels.getPixels(), dstStride, width, height, pixelFormat);
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoY4MPlayer::convertToYUY2(const unsigned char * y, const unsigned char * u, const unsigned char * v, unsigned char * dst){
+
+    int xShift = chromaWidth < width ? 1 : 0;
+    int yShift = chromaHeight < height ? 1 : 0;
+
+    // 2vuy: Cb Y0 Cr Y1, with 4:4:4 chroma just taking the left sample of each pair
+    for(int row = 0; row < height; row++){
+        const unsigned char * yRow = y + (size_t)row * width;
+        const unsigned char * uRow = u + (size_t)(row >> yShift) * chromaWidth;
+        const unsigned char * vRow = v + (size_t)(row >> yShift) * chromaWidth;
+        for(int col = 0; col < width; col += 2){
+            int chroma = col >> xShift;
+            dst[0] = uRow[chroma];
+            dst[1] = yRow[col];
+            if(col + 1 == width){
+                dst += 2;
+                break;
+            }
+            dst[2] = vRow[chroma];
+            dst[3] = yRow[col + 1];
+            dst += 4;
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoY4MPlayer::convertToPlanar(const unsigned char * y, const unsigned char * u, const unsigned char * v){
+
+    int xShift = chromaWidth < width ? 0 : 1;
+    int yShift = chromaHeight < height ? 0 : 1;
+    int planeWidth = width / 2;
+    int planeHeight = height / 2;
+
+    unsigned char * dst = pixels.getPixels();
+    memcpy(dst, y, (size_t)width * height);
+    dst += (size_t)width * height;
+
+    // 4:2:0 streams are already the right shape; 4:2:2 and 4:4:4 (and
+    // mono's neutral plane) just take every other sample
+    if(pixelFormat == OF_PIXELS_I420){
+        unsigned char * dstU = dst;
+        unsigned char * dstV = dst + (size_t)planeWidth * planeHeight;
+        for(int row = 0; row < planeHeight; row++){
+            const unsigned char * uRow = u + (size_t)(row << yShift) * chromaWidth;
+            const unsigned char * vRow = v + (size_t)(row << yShift) * chromaWidth;
+            if(xShift == 0){
+                memcpy(dstU, uRow, planeWidth);
+                memcpy(dstV, vRow, planeWidth);
+            }else{
+                for(int col = 0; col < planeWidth; col++){
+                    dstU[col] = uRow[col << 1];
+                    dstV[col] = vRow[col << 1];
+                }
+            }
+            dstU += planeWidth;
+            dstV += planeWidth;
+        }
+    }else{
+        for(int row = 0; row < planeHeight; row++){
+            const unsigned char * uRow = u + (size_t)(row << yShift) * chromaWidth;
+            const unsigned char * vRow = v + (size_t)(row << yShift) * chromaWidth;
+            for(int col = 0; col < planeWidth; col++){
+                dst[0] = uRow[col << xShift];
+                dst[1] = vRow[col << xShift];
+                dst += 2;
+            }
+        }
+    }
+
+}
+
+//--------------------------------------------------------------
+void ofxThreadedVideoY4MPlayer::closeFrames(){
+    if(bPooledPixels){
+        ofxThreadedVideoBufferPool::getPool().release(pixels);
+        bPooledPixels = false;
+    }
+    if(file != NULL){
+        fclose(file);
+        file = NULL;
+    }
+    frameOffsets.clear();
+    frameData.clear();
+    neutralChroma.clear();
+}
+
+//--------------------------------------------------------------
+bool ofxThreadedVideoY4MPlayer::isPixelFormatSupported(ofPixelFormat pixelFormat) const{
+    return pixelFormat == OF_PIXELS_RGB || pixelFormat == OF_PIXELS_RGBA || pixelFormat == OF_PIXELS_BGRA || pixelFormat == OF_PIXELS_YUY2 ||
+           pixelFormat == OF_PIXELS_I420 || pixelFormat == OF_PIXELS_NV12;
+}
@@ -0,0 +1,95 @@
+/*
+ * ofxThreadedVideoY4MPlayer.h
+ *
+ * Copyright 2010-2016 (c) Matthew Gingold http://gingold.com.au
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * If you're using this software for something cool consider sending
+ * me an email to let me know about your project: m@gingold.com.au
+ *
+ */
+
+
+#ifndef __H_OFXTHREADEDVIDEOY4MPLAYER
+#define __H_OFXTHREADEDVIDEOY4MPLAYER
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ofMain.h"
+#include "ofxThreadedVideoFramePlayer.h"
+
+// pure C++ reference backend for uncompressed YUV4MPEG2 (.y4m) streams, eg.,
+// from ffmpeg -i clip.mov -pix_fmt yuv420p clip.y4m. 8 bit 4:2:0, 4:2:2,
+// 4:4:4 and mono are supported, converted on load to RGB, RGBA, BGRA (by
+// ofxThreadedVideoConvert, BT.601 like the internal shader), YUY2 (in the
+// same 2vuy byte order QuickTime hands out) or I420/NV12 (a straight copy
+// for 4:2:0 streams with an even size). use it with
+// setPlayer<ofxThreadedVideoY4MPlayer>() to run and benchmark the whole
+// engine without QuickTime, eg., headless
+class ofxThreadedVideoY4MPlayer : public ofxThreadedVideoFramePlayer {
+
+public:
+
+    ofxThreadedVideoY4MPlayer();
+    ~ofxThreadedVideoY4MPlayer();
+
+protected:
+
+    enum ChromaType {
+        CHROMA_420 = 0,
+        CHROMA_422,
+        CHROMA_444,
+        CHROMA_MONO
+    };
+
+    bool openFrames(const string& path);
+    bool readFrame(int frame);
+    void closeFrames();
+    bool isPixelFormatSupported(ofPixelFormat pixelFormat) const;
+
+    bool readHeader(const string& path);
+    bool indexFrames();
+    bool seekFile(int64_t offset);
+    int64_t tellFile();
+
+    void convertToRGB(const unsigned char * y, const unsigned char * u, const unsigned char * v);
+    void convertToYUY2(const unsigned char * y, const unsigned char * u, const unsigned char * v, unsigned char * dst);
+    void convertToPlanar(const unsigned char * y, const unsigned char * u, const unsigned char * v);
+
+    FILE * file;
+    ChromaType chromaType;
+    int chromaWidth;
+    int chromaHeight;
+    size_t frameSize;
+
+    vector<int64_t> frameOffsets;   // where each frame's planes start
+    vector<unsigned char> frameData;
+    vector<unsigned char> neutralChroma;   // stands in for mono streams' chroma
+    vector<unsigned char> yuy2Data;        // RGB frames that aren't plain 4:2:0 pass through 2vuy
+
+    bool bPooledPixels;
+
+};
+
+#endif